@@ -0,0 +1,480 @@
+/**
+ * @file bench.cpp
+ * @brief Benchmarks every Vec operation against std::vector, a hand-rolled array and the Vector<T> wrapper.
+ *
+ * @details The suite is C++ only so it can drive std::vector, the vector itself stays C:
+ *      cc -O2 -c vector.c -o vector.o
+ *      c++ -O2 -std=c++17 bench.cpp vector.o -o bench -lpthread
+ *      ./bench [--max-len N] [--reps N] [--max-bytes N] [--quick] [--out bench_output.txt]
+ *
+ * Every (operation, implementation, element size, length) cell is warmed up once, then sampled
+ * at least --reps times (more for short vectors so each cell sees about a million elements).
+ * Setup such as refilling or reshuffling the input is not timed.
+ * Results go to stdout as a table and to bench_output.txt as tab separated values with a header row,
+ * one row per cell, so runs can be diffed to catch regressions.
+ * Lengths go from 10 to 10^8 in powers of ten, capped by --max-len (default 10^7)
+ * and by --max-bytes of element data per vector (default 1 GiB).
+ */
+
+#include "vector.h"
+#include "vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Options
+{
+    size_t max_len = 10000000;
+    size_t max_bytes = (size_t)1 << 30;
+    size_t reps = 7;
+    const char *out = "bench_output.txt";
+};
+
+/* elements of N bytes, ordered by a key stored in their first min(N, 8) bytes */
+template <size_t N>
+struct Elem
+{
+    unsigned char b[N];
+};
+
+template <size_t N>
+constexpr uint64_t key_mask()
+{
+    return N >= 8 ? ~(uint64_t)0 : (((uint64_t)1 << (8 * N)) - 1);
+}
+
+template <size_t N>
+inline uint64_t key_of(const Elem<N> &e)
+{
+    uint64_t k = 0;
+    memcpy(&k, e.b, N < 8 ? N : 8);
+    return k;
+}
+
+/* values never use the all ones key, so it can be searched for as a miss */
+template <size_t N>
+inline Elem<N> make_elem(uint64_t i)
+{
+    uint64_t h = i * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 29;
+    uint64_t k = h % key_mask<N>();
+    Elem<N> e;
+    memset(e.b, (int)(i & 0xFF), N);
+    memcpy(e.b, &k, N < 8 ? N : 8);
+    return e;
+}
+
+template <size_t N>
+int elem_cmp(const void *a, const void *b)
+{
+    uint64_t ka = key_of(*(const Elem<N> *)a), kb = key_of(*(const Elem<N> *)b);
+    return ka < kb ? -1 : ka > kb;
+}
+
+template <size_t N>
+inline bool elem_less(const Elem<N> &a, const Elem<N> &b)
+{
+    return key_of(a) < key_of(b);
+}
+
+/* hand-rolled growable array, what the code base did before Vec */
+template <size_t N>
+struct RawArr
+{
+    Elem<N> *data = nullptr;
+    size_t len = 0;
+    size_t cap = 0;
+
+    ~RawArr() { free(data); }
+    void reserve(size_t n)
+    {
+        if (n <= cap)
+            return;
+        data = (Elem<N> *)realloc(data, n * sizeof(Elem<N>));
+        cap = n;
+    }
+    void push(const Elem<N> &e)
+    {
+        if (len == cap)
+            reserve(cap ? cap * 2 : 10);
+        data[len++] = e;
+    }
+    void insert(size_t idx, const Elem<N> &e)
+    {
+        if (len == cap)
+            reserve(cap ? cap * 2 : 10);
+        memmove(data + idx + 1, data + idx, (len - idx) * sizeof(Elem<N>));
+        data[idx] = e;
+        len++;
+    }
+    void remove(size_t idx)
+    {
+        memmove(data + idx, data + idx + 1, (len - idx - 1) * sizeof(Elem<N>));
+        len--;
+    }
+    void remove_fast(size_t idx) { data[idx] = data[--len]; }
+};
+
+using Clock = std::chrono::steady_clock;
+
+struct Result
+{
+    std::string op, impl;
+    size_t elem_size, len, ops, samples;
+    double min_ns, p50_ns, p90_ns, p99_ns, max_ns;
+};
+
+double percentile(std::vector<double> &sorted, double p)
+{
+    size_t idx = (size_t)(p * (double)(sorted.size() - 1) + 0.5);
+    return sorted[idx];
+}
+
+/* runs setup untimed and body timed, once as warmup and then samples times */
+Result measure(const std::string &op, const std::string &impl, size_t elem_size, size_t len, size_t ops, size_t samples,
+               const std::function<void()> &setup, const std::function<void()> &body)
+{
+    std::vector<double> ns;
+    ns.reserve(samples);
+    setup();
+    body();
+    for (size_t s = 0; s < samples; s++)
+    {
+        setup();
+        Clock::time_point t0 = Clock::now();
+        body();
+        Clock::time_point t1 = Clock::now();
+        ns.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+    std::sort(ns.begin(), ns.end());
+    return Result{op, impl, elem_size, len, ops, samples,
+                  ns.front(), percentile(ns, 0.5), percentile(ns, 0.9), percentile(ns, 0.99), ns.back()};
+}
+
+volatile uint64_t sink;
+
+template <size_t N>
+void bench_size(const Options &opt, std::vector<Result> &results)
+{
+    typedef Elem<N> E;
+    for (size_t len = 10; len <= opt.max_len && len * N <= opt.max_bytes; len *= 10)
+    {
+        /* quadratic operations do k of them, bounded to about 16 MiB of memmove or scanning per sample */
+        size_t k = ((size_t)1 << 24) / (len * N);
+        k = std::max<size_t>(1, std::min<size_t>(k, std::min<size_t>(len / 2, 1000)));
+        size_t samples = std::max(opt.reps, std::min<size_t>(1000, 1000000 / len));
+        if (len >= 10000000)
+            samples = std::min<size_t>(samples, 3);
+
+        std::vector<E> src(len);
+        for (size_t i = 0; i < len; i++)
+            src[i] = make_elem<N>(i);
+        E miss;
+        memset(miss.b, 0xFF, N);
+
+        Vec *v = vec_new(len, N, elem_cmp<N>, NULL, NULL);
+        Vec *other = vec_new(len, N, elem_cmp<N>, NULL, NULL);
+        std::vector<E> sv, sother;
+        RawArr<N> ra, rother;
+        Vector<E> hv, hother;
+        auto fill_vec = [&] {
+            v->len = 0;
+            vec_insert_n(v, 0, src.data(), len);
+        };
+        auto fill_std = [&] { sv.assign(src.begin(), src.end()); };
+        auto fill_raw = [&] {
+            ra.reserve(len);
+            memcpy(ra.data, src.data(), len * N);
+            ra.len = len;
+        };
+        auto fill_hpp = [&] {
+            hv.clear();
+            hv.insert(hv.end(), src.data(), src.data() + len);
+        };
+        fill_vec();
+        fill_std();
+        fill_raw();
+        fill_hpp();
+        vec_insert_n(other, 0, src.data(), len);
+        hother.insert(hother.end(), src.data(), src.data() + len);
+        sother = src;
+        rother.reserve(len);
+        memcpy(rother.data, src.data(), len * N);
+        rother.len = len;
+        auto nothing = [] {};
+
+        /* push_back from an empty container, growth included */
+        results.push_back(measure("push_back", "vec", N, len, len, samples, nothing, [&] {
+            Vec *t = vec_new(VECTOR_DEFAULT_CAP, N, NULL, NULL, NULL);
+            for (size_t i = 0; i < len; i++)
+                vec_push_back(t, &src[i]);
+            sink = t->len;
+            vec_free(t);
+        }));
+        results.push_back(measure("push_back", "std", N, len, len, samples, nothing, [&] {
+            std::vector<E> t;
+            for (size_t i = 0; i < len; i++)
+                t.push_back(src[i]);
+            sink = t.size();
+        }));
+        results.push_back(measure("push_back", "raw", N, len, len, samples, nothing, [&] {
+            RawArr<N> t;
+            for (size_t i = 0; i < len; i++)
+                t.push(src[i]);
+            sink = t.len;
+        }));
+        results.push_back(measure("push_back", "hpp", N, len, len, samples, nothing, [&] {
+            Vector<E> t;
+            for (size_t i = 0; i < len; i++)
+                t.push_back(src[i]);
+            sink = t.size();
+        }));
+
+        /* k inserts and removes in the middle */
+        results.push_back(measure("insert", "vec", N, len, k, samples, fill_vec, [&] {
+            for (size_t i = 0; i < k; i++)
+                vec_insert(v, v->len / 2, &src[i]);
+        }));
+        results.push_back(measure("insert", "std", N, len, k, samples, fill_std, [&] {
+            for (size_t i = 0; i < k; i++)
+                sv.insert(sv.begin() + sv.size() / 2, src[i]);
+        }));
+        results.push_back(measure("insert", "raw", N, len, k, samples, fill_raw, [&] {
+            for (size_t i = 0; i < k; i++)
+                ra.insert(ra.len / 2, src[i]);
+        }));
+        results.push_back(measure("insert", "hpp", N, len, k, samples, fill_hpp, [&] {
+            for (size_t i = 0; i < k; i++)
+                hv.insert(hv.begin() + hv.size() / 2, src[i]);
+        }));
+        results.push_back(measure("remove", "vec", N, len, k, samples, fill_vec, [&] {
+            for (size_t i = 0; i < k; i++)
+                vec_remove(v, v->len / 2);
+        }));
+        results.push_back(measure("remove", "std", N, len, k, samples, fill_std, [&] {
+            for (size_t i = 0; i < k; i++)
+                sv.erase(sv.begin() + sv.size() / 2);
+        }));
+        results.push_back(measure("remove", "raw", N, len, k, samples, fill_raw, [&] {
+            for (size_t i = 0; i < k; i++)
+                ra.remove(ra.len / 2);
+        }));
+        results.push_back(measure("remove", "hpp", N, len, k, samples, fill_hpp, [&] {
+            for (size_t i = 0; i < k; i++)
+                hv.erase(hv.begin() + hv.size() / 2);
+        }));
+        results.push_back(measure("remove_fast", "vec", N, len, k, samples, fill_vec, [&] {
+            for (size_t i = 0; i < k; i++)
+                vec_remove_fast(v, (i * 7919) % v->len);
+        }));
+        results.push_back(measure("remove_fast", "std", N, len, k, samples, fill_std, [&] {
+            for (size_t i = 0; i < k; i++)
+            {
+                sv[(i * 7919) % sv.size()] = sv.back();
+                sv.pop_back();
+            }
+        }));
+        results.push_back(measure("remove_fast", "raw", N, len, k, samples, fill_raw, [&] {
+            for (size_t i = 0; i < k; i++)
+                ra.remove_fast((i * 7919) % ra.len);
+        }));
+        results.push_back(measure("remove_fast", "hpp", N, len, k, samples, fill_hpp, [&] {
+            for (size_t i = 0; i < k; i++)
+            {
+                hv[(i * 7919) % hv.size()] = hv.back();
+                hv.pop_back();
+            }
+        }));
+
+        /* k full scans for a key that is never present */
+        fill_vec();
+        fill_std();
+        fill_raw();
+        fill_hpp();
+        results.push_back(measure("find", "vec", N, len, k * len, samples, nothing, [&] {
+            for (size_t i = 0; i < k; i++)
+                sink = (uint64_t)(uintptr_t)vec_find(v, &miss);
+        }));
+        results.push_back(measure("find", "std", N, len, k * len, samples, nothing, [&] {
+            uint64_t mk = key_of(miss);
+            for (size_t i = 0; i < k; i++)
+                sink = (uint64_t)(std::find_if(sv.begin(), sv.end(), [mk](const E &e) { return key_of(e) == mk; }) - sv.begin());
+        }));
+        results.push_back(measure("find", "raw", N, len, k * len, samples, nothing, [&] {
+            uint64_t mk = key_of(miss);
+            for (size_t i = 0; i < k; i++)
+            {
+                size_t j = 0;
+                while (j < ra.len && key_of(ra.data[j]) != mk)
+                    j++;
+                sink = j;
+            }
+        }));
+        results.push_back(measure("find", "hpp", N, len, k * len, samples, nothing, [&] {
+            uint64_t mk = key_of(miss);
+            for (size_t i = 0; i < k; i++)
+                sink = (uint64_t)(std::find_if(hv.begin(), hv.end(), [mk](const E &e) { return key_of(e) == mk; }) - hv.begin());
+        }));
+
+        /* sort of the scrambled input, reverse, copy, append and a read only walk */
+        results.push_back(measure("sort", "vec", N, len, len, samples, fill_vec, [&] { vec_sort(v); }));
+        results.push_back(measure("sort", "std", N, len, len, samples, fill_std, [&] { std::sort(sv.begin(), sv.end(), elem_less<N>); }));
+        results.push_back(measure("sort", "raw", N, len, len, samples, fill_raw, [&] { qsort(ra.data, ra.len, N, elem_cmp<N>); }));
+        results.push_back(measure("sort", "hpp", N, len, len, samples, fill_hpp, [&] { std::sort(hv.begin(), hv.end(), elem_less<N>); }));
+
+        results.push_back(measure("reverse", "vec", N, len, len, samples, nothing, [&] { vec_reverse(v); }));
+        results.push_back(measure("reverse", "std", N, len, len, samples, nothing, [&] { std::reverse(sv.begin(), sv.end()); }));
+        results.push_back(measure("reverse", "raw", N, len, len, samples, nothing, [&] {
+            for (size_t i = 0, j = ra.len - 1; i < j; i++, j--)
+                std::swap(ra.data[i], ra.data[j]);
+        }));
+        results.push_back(measure("reverse", "hpp", N, len, len, samples, nothing, [&] { std::reverse(hv.begin(), hv.end()); }));
+
+        Vec *copy = NULL;
+        results.push_back(measure("copy", "vec", N, len, len, samples, [&] { if (copy) vec_free(copy); copy = NULL; },
+                                  [&] { copy = vec_copy(v); }));
+        if (copy)
+            vec_free(copy);
+        std::vector<E> scopy;
+        results.push_back(measure("copy", "std", N, len, len, samples, [&] { std::vector<E>().swap(scopy); },
+                                  [&] { scopy = sv; }));
+        E *rcopy = NULL;
+        results.push_back(measure("copy", "raw", N, len, len, samples, [&] { free(rcopy); rcopy = NULL; }, [&] {
+            rcopy = (E *)malloc(ra.len * N);
+            memcpy(rcopy, ra.data, ra.len * N);
+        }));
+        free(rcopy);
+        Vector<E> hcopy;
+        results.push_back(measure("copy", "hpp", N, len, len, samples, [&] { Vector<E>().swap(hcopy); },
+                                  [&] { hcopy = hv.clone(); }));
+
+        results.push_back(measure("append", "vec", N, len, len, samples, [&] { v->len = 0; }, [&] { vec_append(v, other); }));
+        results.push_back(measure("append", "std", N, len, len, samples, [&] { sv.clear(); },
+                                  [&] { sv.insert(sv.end(), sother.begin(), sother.end()); }));
+        results.push_back(measure("append", "raw", N, len, len, samples, [&] { ra.len = 0; }, [&] {
+            ra.reserve(ra.len + rother.len);
+            memcpy(ra.data + ra.len, rother.data, rother.len * N);
+            ra.len += rother.len;
+        }));
+        results.push_back(measure("append", "hpp", N, len, len, samples, [&] { hv.clear(); },
+                                  [&] { hv.insert(hv.end(), hother.begin(), hother.end()); }));
+
+        fill_vec();
+        results.push_back(measure("for_each", "vec", N, len, len, samples, nothing, [&] {
+            uint64_t sum = 0;
+            void *e; /* the C99 macros are not visible to C++, and void * is the only type the ANSI ones assign to */
+            V_FOR_EACH_ANSI(v, e)
+            {
+                sum += ((E *)e)->b[0];
+            }
+            sink = sum;
+        }));
+        results.push_back(measure("for_each_fast", "vec", N, len, len, samples, nothing, [&] {
+            uint64_t sum = 0;
+            void *e;
+            V_FOR_EACH_FAST_ANSI(v, e)
+            {
+                sum += ((E *)e)->b[0];
+            }
+            sink = sum;
+        }));
+        results.push_back(measure("for_each", "std", N, len, len, samples, nothing, [&] {
+            uint64_t sum = 0;
+            for (const E &e : sv)
+                sum += e.b[0];
+            sink = sum;
+        }));
+        results.push_back(measure("for_each", "raw", N, len, len, samples, nothing, [&] {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < ra.len; i++)
+                sum += ra.data[i].b[0];
+            sink = sum;
+        }));
+        results.push_back(measure("for_each", "hpp", N, len, len, samples, nothing, [&] {
+            uint64_t sum = 0;
+            for (const E &e : hv)
+                sum += e.b[0];
+            sink = sum;
+        }));
+
+        vec_free(v);
+        vec_free(other);
+        fprintf(stderr, "elem %zu len %zu done\n", N, len);
+    }
+}
+
+void write_results(const Options &opt, const std::vector<Result> &results)
+{
+    FILE *f = fopen(opt.out, "w");
+    if (!f)
+    {
+        perror("bench: Could not open the output file.");
+        return;
+    }
+    fprintf(f, "op\timpl\telem_size\tlen\tops\tsamples\tmin_ns\tp50_ns\tp90_ns\tp99_ns\tmax_ns\tp50_ns_per_op\n");
+    for (const Result &r : results)
+    {
+        fprintf(f, "%s\t%s\t%zu\t%zu\t%zu\t%zu\t%.0f\t%.0f\t%.0f\t%.0f\t%.0f\t%.3f\n", r.op.c_str(), r.impl.c_str(), r.elem_size,
+                r.len, r.ops, r.samples, r.min_ns, r.p50_ns, r.p90_ns, r.p99_ns, r.max_ns, r.p50_ns / (double)r.ops);
+    }
+    fclose(f);
+}
+
+void print_results(const std::vector<Result> &results)
+{
+    printf("%-14s %-10s %5s %10s %12s %12s %12s\n", "op", "impl", "elem", "len", "p50 ns/op", "p90 ns/op", "p99 ns/op");
+    for (const Result &r : results)
+    {
+        printf("%-14s %-10s %5zu %10zu %12.3f %12.3f %12.3f\n", r.op.c_str(), r.impl.c_str(), r.elem_size, r.len,
+               r.p50_ns / (double)r.ops, r.p90_ns / (double)r.ops, r.p99_ns / (double)r.ops);
+    }
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--quick"))
+        {
+            opt.max_len = 100000;
+            opt.reps = 3;
+        }
+        else if (!strcmp(argv[i], "--max-len") && i + 1 < argc)
+            opt.max_len = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--max-bytes") && i + 1 < argc)
+            opt.max_bytes = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--reps") && i + 1 < argc)
+            opt.reps = std::max<size_t>(1, strtoull(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            opt.out = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--max-len N] [--max-bytes N] [--reps N] [--quick] [--out FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    bench_size<1>(opt, results);
+    bench_size<4>(opt, results);
+    bench_size<8>(opt, results);
+    bench_size<64>(opt, results);
+    bench_size<256>(opt, results);
+
+    print_results(results);
+    write_results(opt, results);
+    return 0;
+}
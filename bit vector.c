@@ -0,0 +1,269 @@
+#include "bit vector.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BITVEC_HAVE_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BITVEC_HAVE_SSE2
+#endif
+
+#define WORD_BITS 64
+#define WORD_COUNT(bits) (((bits) + WORD_BITS - 1) / WORD_BITS)
+#define WORDS(bv) ((uint64_t *)(bv)->words->data)
+
+static size_t bit_popcount(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (size_t)((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/* x must not be 0 */
+static size_t bit_ctz(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_ctzll(x);
+#else
+    size_t n = 0;
+    while (!(x & 1))
+    {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+BitVec *bitvec_new(size_t capacity)
+{
+    BitVec *bv = malloc(sizeof(BitVec));
+    VEC_ASSERT(bv);
+    *bv = (BitVec){.words = vec_new_aligned(WORD_COUNT(capacity) ? WORD_COUNT(capacity) : 1, sizeof(uint64_t), 32, NULL, NULL, NULL),
+                   .len = 0};
+    return bv;
+}
+
+void bitvec_free(BitVec *bv)
+{
+    VALIDATE_VECTOR(bv);
+    vec_free(bv->words);
+    free(bv);
+}
+
+void bitvec_push(BitVec *bv, int bit)
+{
+    VALIDATE_VECTOR(bv);
+    if (bv->len % WORD_BITS == 0)
+    {
+        uint64_t zero = 0;
+        vec_push_back(bv->words, &zero);
+    }
+    if (bit)
+        WORDS(bv)[bv->len / WORD_BITS] |= (uint64_t)1 << (bv->len % WORD_BITS);
+    bv->len++;
+}
+
+int bitvec_get(BitVec *bv, size_t idx)
+{
+    VALIDATE_VECTOR(bv);
+    if (idx >= bv->len)
+        return 0;
+    return (int)((WORDS(bv)[idx / WORD_BITS] >> (idx % WORD_BITS)) & 1);
+}
+
+void bitvec_set(BitVec *bv, size_t idx)
+{
+    VALIDATE_VECTOR(bv);
+    if (idx >= bv->len)
+        return;
+    WORDS(bv)[idx / WORD_BITS] |= (uint64_t)1 << (idx % WORD_BITS);
+}
+
+void bitvec_clear(BitVec *bv, size_t idx)
+{
+    VALIDATE_VECTOR(bv);
+    if (idx >= bv->len)
+        return;
+    WORDS(bv)[idx / WORD_BITS] &= ~((uint64_t)1 << (idx % WORD_BITS));
+}
+
+void bitvec_insert(BitVec *bv, size_t idx, int bit)
+{
+    VALIDATE_VECTOR(bv);
+    if (idx > bv->len)
+        return;
+    if (bv->len % WORD_BITS == 0)
+    {
+        uint64_t zero = 0;
+        vec_push_back(bv->words, &zero);
+    }
+    uint64_t *w = WORDS(bv);
+    size_t first = idx / WORD_BITS, i;
+    /* every word above the insertion point moves up one bit, taking the top bit of the word below */
+    for (i = bv->words->len - 1; i > first; i--)
+        w[i] = (w[i] << 1) | (w[i - 1] >> (WORD_BITS - 1));
+    uint64_t low_mask = ((uint64_t)1 << (idx % WORD_BITS)) - 1;
+    uint64_t low = w[first] & low_mask;
+    w[first] = ((w[first] & ~low_mask) << 1) | low;
+    if (bit)
+        w[first] |= (uint64_t)1 << (idx % WORD_BITS);
+    bv->len++;
+}
+
+void bitvec_remove(BitVec *bv, size_t idx)
+{
+    VALIDATE_VECTOR(bv);
+    if (idx >= bv->len)
+        return;
+    uint64_t *w = WORDS(bv);
+    size_t first = idx / WORD_BITS, last = bv->words->len - 1, i;
+    uint64_t low_mask = ((uint64_t)1 << (idx % WORD_BITS)) - 1;
+    uint64_t high = (w[first] >> 1) & ~low_mask;
+    w[first] = (w[first] & low_mask) | high;
+    /* every word from the removal point takes the low bit of the word above as its top bit */
+    for (i = first; i < last; i++)
+    {
+        w[i] |= w[i + 1] << (WORD_BITS - 1);
+        w[i + 1] >>= 1;
+    }
+    bv->len--;
+    if (bv->len % WORD_BITS == 0)
+        bv->words->len--;
+}
+
+size_t bitvec_count(BitVec *bv)
+{
+    VALIDATE_VECTOR(bv);
+    const uint64_t *w = WORDS(bv);
+    size_t n = bv->words->len, i, total = 0;
+    for (i = 0; i < n; i++)
+        total += bit_popcount(w[i]);
+    return total;
+}
+
+size_t bitvec_find_first_set(BitVec *bv)
+{
+    VALIDATE_VECTOR(bv);
+    const uint64_t *w = WORDS(bv);
+    size_t n = bv->words->len, i;
+    for (i = 0; i < n; i++)
+        if (w[i])
+            return i * WORD_BITS + bit_ctz(w[i]);
+    return BITVEC_NONE;
+}
+
+size_t bitvec_find_next_set(BitVec *bv, size_t idx)
+{
+    VALIDATE_VECTOR(bv);
+    if (idx == BITVEC_NONE || idx + 1 >= bv->len)
+        return BITVEC_NONE;
+    idx++;
+    const uint64_t *w = WORDS(bv);
+    size_t n = bv->words->len, i = idx / WORD_BITS;
+    uint64_t word = w[i] & (~(uint64_t)0 << (idx % WORD_BITS));
+    while (!word)
+    {
+        if (++i >= n)
+            return BITVEC_NONE;
+        word = w[i];
+    }
+    return i * WORD_BITS + bit_ctz(word);
+}
+
+/* applies op to n words, 256 or 128 bits at a time where available, then a word at a time */
+#if defined(BITVEC_HAVE_AVX2)
+#define BITVEC_KERNEL(name, op64, op_avx, op_sse)                                        \
+    static void name(uint64_t *d, const uint64_t *a, const uint64_t *b, size_t n)      \
+    {                                                                                  \
+        size_t i = 0;                                                                  \
+        for (; i + 4 <= n; i += 4)                                                     \
+        {                                                                              \
+            __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));                 \
+            __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));                 \
+            _mm256_storeu_si256((__m256i *)(d + i), op_avx(va, vb));                   \
+        }                                                                              \
+        for (; i < n; i++)                                                             \
+            d[i] = op64(a[i], b[i]);                                                   \
+    }
+#elif defined(BITVEC_HAVE_SSE2)
+#define BITVEC_KERNEL(name, op64, op_avx, op_sse)                                        \
+    static void name(uint64_t *d, const uint64_t *a, const uint64_t *b, size_t n)      \
+    {                                                                                  \
+        size_t i = 0;                                                                  \
+        for (; i + 2 <= n; i += 2)                                                     \
+        {                                                                              \
+            __m128i va = _mm_loadu_si128((const __m128i *)(a + i));                    \
+            __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));                    \
+            _mm_storeu_si128((__m128i *)(d + i), op_sse(va, vb));                      \
+        }                                                                              \
+        for (; i < n; i++)                                                             \
+            d[i] = op64(a[i], b[i]);                                                   \
+    }
+#else
+#define BITVEC_KERNEL(name, op64, op_avx, op_sse)                                        \
+    static void name(uint64_t *d, const uint64_t *a, const uint64_t *b, size_t n)      \
+    {                                                                                  \
+        size_t i;                                                                      \
+        for (i = 0; i < n; i++)                                                        \
+            d[i] = op64(a[i], b[i]);                                                   \
+    }
+#endif
+
+#define OP_AND(x, y) ((x) & (y))
+#define OP_OR(x, y) ((x) | (y))
+#define OP_XOR(x, y) ((x) ^ (y))
+#define OP_ANDNOT(x, y) ((x) & ~(y))
+/* the intrinsic andnot complements its first operand */
+#define OP_ANDNOT_AVX(x, y) _mm256_andnot_si256(y, x)
+#define OP_ANDNOT_SSE(x, y) _mm_andnot_si128(y, x)
+
+BITVEC_KERNEL(bitvec_and_words, OP_AND, _mm256_and_si256, _mm_and_si128)
+BITVEC_KERNEL(bitvec_or_words, OP_OR, _mm256_or_si256, _mm_or_si128)
+BITVEC_KERNEL(bitvec_xor_words, OP_XOR, _mm256_xor_si256, _mm_xor_si128)
+BITVEC_KERNEL(bitvec_andnot_words, OP_ANDNOT, OP_ANDNOT_AVX, OP_ANDNOT_SSE)
+
+/* every operation maps zero bits past len to zero, so the result keeps the invariant without masking */
+static int bitvec_binary(BitVec *dest, BitVec *a, BitVec *b, void (*kernel)(uint64_t *, const uint64_t *, const uint64_t *, size_t))
+{
+    VALIDATE_VECTOR(dest);
+    VALIDATE_VECTOR(a);
+    VALIDATE_VECTOR(b);
+    if (a->len != b->len)
+        return 1;
+    size_t n = a->words->len;
+    vec_reserve(dest->words, n);
+    dest->words->len = n;
+    dest->len = a->len;
+    kernel(WORDS(dest), WORDS(a), WORDS(b), n);
+    return 0;
+}
+
+int bitvec_and(BitVec *dest, BitVec *a, BitVec *b)
+{
+    return bitvec_binary(dest, a, b, bitvec_and_words);
+}
+
+int bitvec_or(BitVec *dest, BitVec *a, BitVec *b)
+{
+    return bitvec_binary(dest, a, b, bitvec_or_words);
+}
+
+int bitvec_xor(BitVec *dest, BitVec *a, BitVec *b)
+{
+    return bitvec_binary(dest, a, b, bitvec_xor_words);
+}
+
+int bitvec_andnot(BitVec *dest, BitVec *a, BitVec *b)
+{
+    return bitvec_binary(dest, a, b, bitvec_andnot_words);
+}
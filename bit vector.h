@@ -0,0 +1,147 @@
+/**
+ * @file bit vector.h
+ * @brief Packed vector of bits stored 64 to a word in a Vec.
+ *
+ * @details Uses an eighth of the memory of a Vec of bytes used as flags, counts with popcount
+ * and combines whole vectors a register at a time. Bits past len are always zero.
+ * Link bit vector.c and vector.c.
+ */
+
+#ifndef BIT_VECTOR_H_
+#define BIT_VECTOR_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "vector.h"
+
+/* returned by the find functions when there is no set bit */
+#define BITVEC_NONE ((size_t)-1)
+
+    typedef struct BitVec
+    {
+        Vec *words; /* uint64_t words, bit i is bit i % 64 of word i / 64 */
+        size_t len; /* number of bits */
+    } BitVec;
+
+    /**
+     * @brief Creates an empty bit vector.
+     *
+     * @param capacity Number of bits to reserve space for.
+     * @return BitVec*
+     */
+    BitVec *bitvec_new(size_t capacity);
+
+    /**
+     * @brief Frees the bit vector.
+     *
+     * @param bv Bit vector to free.
+     */
+    void bitvec_free(BitVec *bv);
+
+    /**
+     * @brief Appends a bit.
+     *
+     * @param bv Bit vector to push into.
+     * @param bit Zero for a clear bit, anything else for a set bit.
+     */
+    void bitvec_push(BitVec *bv, int bit);
+
+    /**
+     * @brief Returns the bit at idx.
+     *
+     * @param bv Bit vector to read.
+     * @param idx Index of the bit.
+     * @return int 1 if set, 0 if clear or out of bounds.
+     */
+    int bitvec_get(BitVec *bv, size_t idx);
+
+    /**
+     * @brief Sets the bit at idx to 1, does nothing when out of bounds.
+     *
+     */
+    void bitvec_set(BitVec *bv, size_t idx);
+
+    /**
+     * @brief Sets the bit at idx to 0, does nothing when out of bounds.
+     *
+     */
+    void bitvec_clear(BitVec *bv, size_t idx);
+
+    /**
+     * @brief Inserts a bit before idx, shifting the later bits up by one.
+     *
+     * @param bv Bit vector to insert into.
+     * @param idx Index to insert at, len appends.
+     * @param bit Zero for a clear bit, anything else for a set bit.
+     */
+    void bitvec_insert(BitVec *bv, size_t idx, int bit);
+
+    /**
+     * @brief Removes the bit at idx, shifting the later bits down by one.
+     *
+     * @param bv Bit vector to remove from.
+     * @param idx Index of the bit.
+     */
+    void bitvec_remove(BitVec *bv, size_t idx);
+
+    /**
+     * @brief Counts the set bits.
+     *
+     * @param bv Bit vector to count.
+     * @return size_t
+     */
+    size_t bitvec_count(BitVec *bv);
+
+    /**
+     * @brief Returns the index of the lowest set bit.
+     *
+     * @param bv Bit vector to search.
+     * @return size_t BITVEC_NONE when no bit is set.
+     */
+    size_t bitvec_find_first_set(BitVec *bv);
+
+    /**
+     * @brief Returns the index of the lowest set bit after idx, for walking the set bits from bitvec_find_first_set.
+     *
+     * @param bv Bit vector to search.
+     * @param idx Index to search after.
+     * @return size_t BITVEC_NONE when no later bit is set.
+     */
+    size_t bitvec_find_next_set(BitVec *bv, size_t idx);
+
+    /**
+     * @brief dest = a & b.
+     *
+     * @param dest Result, may be a or b, resized to their length.
+     * @param a First operand.
+     * @param b Second operand.
+     * @return int 0 on success, 1 when a and b have different lengths.
+     */
+    int bitvec_and(BitVec *dest, BitVec *a, BitVec *b);
+
+    /**
+     * @brief dest = a | b, see bitvec_and.
+     *
+     */
+    int bitvec_or(BitVec *dest, BitVec *a, BitVec *b);
+
+    /**
+     * @brief dest = a ^ b, see bitvec_and.
+     *
+     */
+    int bitvec_xor(BitVec *dest, BitVec *a, BitVec *b);
+
+    /**
+     * @brief dest = a & ~b, the bits of a that are not in b, see bitvec_and.
+     *
+     */
+    int bitvec_andnot(BitVec *dest, BitVec *a, BitVec *b);
+
+#ifdef __cplusplus
+} /* Extern "C" */
+#endif
+
+#endif /* BIT_VECTOR_H_ */
@@ -0,0 +1,290 @@
+#include "compressed vector.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define COMPVEC_HAVE_AVX2
+#endif
+
+#define DELTAS (COMPVEC_BLOCK - 1)
+#define WORDS(cv) ((uint64_t *)(cv)->packed->data)
+#define BLOCK(cv, b) ((CompVecBlock *)vec_at((cv)->blocks, b))
+#define FIRST(cv, b) (*(uint64_t *)vec_at((cv)->firsts, b))
+
+CompVec *compvec_new(void)
+{
+    CompVec *cv = malloc(sizeof(CompVec));
+    VEC_ASSERT(cv);
+    uint64_t pad = 0;
+    *cv = (CompVec){.firsts = vec_new(VECTOR_DEFAULT_CAP, sizeof(uint64_t), vec_ull_cmp, NULL, NULL),
+                    .blocks = vec_new(VECTOR_DEFAULT_CAP, sizeof(CompVecBlock), NULL, NULL, NULL),
+                    .packed = vec_new(VECTOR_DEFAULT_CAP, sizeof(uint64_t), NULL, NULL, NULL)};
+    /* the unpack kernel always reads the word after the one a value starts in */
+    vec_push_back(cv->packed, &pad);
+    return cv;
+}
+
+void compvec_free(CompVec *cv)
+{
+    VALIDATE_VECTOR(cv);
+    vec_free(cv->firsts);
+    vec_free(cv->blocks);
+    vec_free(cv->packed);
+    free(cv);
+}
+
+static unsigned compvec_bit_width(uint64_t x)
+{
+    unsigned bits = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    if (x)
+        bits = 64 - (unsigned)__builtin_clzll(x);
+#else
+    while (x)
+    {
+        bits++;
+        x >>= 1;
+    }
+#endif
+    return bits;
+}
+
+#ifdef COMPVEC_HAVE_AVX2
+/* four values per step, each lane gathers the word its value starts in and the next one. Shift counts of 64 give 0 */
+static size_t compvec_unpack_avx2(const uint64_t *words, unsigned bits, uint64_t base, size_t n, uint64_t *out)
+{
+    size_t i;
+    const __m256i mask = _mm256_set1_epi64x((long long)(bits == 64 ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1));
+    const __m256i vbase = _mm256_set1_epi64x((long long)base);
+    const __m256i step = _mm256_set1_epi64x((long long)(4 * bits));
+    const __m256i low6 = _mm256_set1_epi64x(63), one = _mm256_set1_epi64x(1), sixty_four = _mm256_set1_epi64x(64);
+    __m256i pos = _mm256_setr_epi64x(0, (long long)bits, (long long)(2 * bits), (long long)(3 * bits));
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m256i idx = _mm256_srli_epi64(pos, 6);
+        __m256i shift = _mm256_and_si256(pos, low6);
+        __m256i w0 = _mm256_i64gather_epi64((const long long *)words, idx, 8);
+        __m256i w1 = _mm256_i64gather_epi64((const long long *)words, _mm256_add_epi64(idx, one), 8);
+        __m256i lo = _mm256_srlv_epi64(w0, shift);
+        __m256i hi = _mm256_sllv_epi64(w1, _mm256_sub_epi64(sixty_four, shift));
+        __m256i v = _mm256_add_epi64(_mm256_and_si256(_mm256_or_si256(lo, hi), mask), vbase);
+        _mm256_storeu_si256((__m256i *)(out + i), v);
+        pos = _mm256_add_epi64(pos, step);
+    }
+    return i;
+}
+#endif
+
+/*
+    unpacks n values of bits width and adds base. Every value needs its own shift count, which SSE2 can not
+    do per lane, so only AVX2 builds get a vector kernel. The scalar loop finishes what it leaves.
+*/
+static void compvec_unpack(const uint64_t *words, unsigned bits, uint64_t base, size_t n, uint64_t *out)
+{
+    size_t i = 0;
+    if (!bits)
+    {
+        for (i = 0; i < n; i++)
+            out[i] = base;
+        return;
+    }
+#ifdef COMPVEC_HAVE_AVX2
+    i = compvec_unpack_avx2(words, bits, base, n, out);
+#endif
+    uint64_t mask = bits == 64 ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1;
+    for (; i < n; i++)
+    {
+        size_t pos = i * bits;
+        unsigned shift = (unsigned)(pos & 63);
+        uint64_t lo = words[pos >> 6] >> shift;
+        /* two shifts so a shift of 0 does not become an undefined shift by 64 */
+        uint64_t hi = (words[(pos >> 6) + 1] << 1) << (63 - shift);
+        out[i] = ((lo | hi) & mask) + base;
+    }
+}
+
+static void compvec_pack(uint64_t *words, unsigned bits, const uint64_t *values, size_t n)
+{
+    size_t i;
+    if (!bits)
+        return;
+    for (i = 0; i < n; i++)
+    {
+        size_t pos = i * bits;
+        unsigned shift = (unsigned)(pos & 63);
+        words[pos >> 6] |= values[i] << shift;
+        if (shift + bits > 64)
+            words[(pos >> 6) + 1] |= values[i] >> (64 - shift);
+    }
+}
+
+/* packs the full tail into a new block */
+static void compvec_seal(CompVec *cv)
+{
+    uint64_t deltas[DELTAS];
+    uint64_t base = UINT64_MAX, spread = 0;
+    size_t i;
+    for (i = 0; i < DELTAS; i++)
+    {
+        deltas[i] = cv->tail[i + 1] - cv->tail[i];
+        if (deltas[i] < base)
+            base = deltas[i];
+    }
+    for (i = 0; i < DELTAS; i++)
+    {
+        deltas[i] -= base;
+        spread |= deltas[i];
+    }
+    CompVecBlock blk = {.base = base, .word = cv->packed->len - 1, .bits = (uint8_t)compvec_bit_width(spread)};
+    size_t nwords = (DELTAS * (size_t)blk.bits + 63) / 64;
+
+    /* the old pad word becomes the first word of the block and a new pad follows it */
+    vec_reserve(cv->packed, blk.word + nwords + 1);
+    memset(WORDS(cv) + blk.word, 0, (nwords + 1) * sizeof(uint64_t));
+    cv->packed->len = blk.word + nwords + 1;
+    compvec_pack(WORDS(cv) + blk.word, blk.bits, deltas, DELTAS);
+
+    vec_push_back(cv->firsts, &cv->tail[0]);
+    vec_push_back(cv->blocks, &blk);
+    cv->tail_len = 0;
+}
+
+int compvec_push(CompVec *cv, uint64_t value)
+{
+    VALIDATE_VECTOR(cv);
+    if (cv->len && value < compvec_at(cv, cv->len - 1))
+        return 1;
+    cv->tail[cv->tail_len++] = value;
+    cv->len++;
+    if (cv->tail_len == COMPVEC_BLOCK)
+        compvec_seal(cv);
+    return 0;
+}
+
+size_t compvec_decode_block(CompVec *cv, size_t block, uint64_t *out)
+{
+    VALIDATE_VECTOR(cv);
+    size_t nblocks = cv->blocks->len, i;
+    if (block == nblocks)
+    {
+        memcpy(out, cv->tail, cv->tail_len * sizeof(uint64_t));
+        return cv->tail_len;
+    }
+    if (block > nblocks)
+        return 0;
+    CompVecBlock *blk = BLOCK(cv, block);
+    out[0] = FIRST(cv, block);
+    compvec_unpack(WORDS(cv) + blk->word, blk->bits, blk->base, DELTAS, out + 1);
+    for (i = 1; i < COMPVEC_BLOCK; i++)
+        out[i] += out[i - 1];
+    return COMPVEC_BLOCK;
+}
+
+uint64_t compvec_at(CompVec *cv, size_t idx)
+{
+    VALIDATE_VECTOR(cv);
+    if (idx >= cv->len)
+        return 0;
+    size_t block = idx / COMPVEC_BLOCK, j = idx % COMPVEC_BLOCK, i;
+    if (block == cv->blocks->len)
+        return cv->tail[j];
+    uint64_t deltas[DELTAS], value = FIRST(cv, block);
+    CompVecBlock *blk = BLOCK(cv, block);
+    compvec_unpack(WORDS(cv) + blk->word, blk->bits, blk->base, j, deltas);
+    for (i = 0; i < j; i++)
+        value += deltas[i];
+    return value;
+}
+
+size_t compvec_lower_bound(CompVec *cv, uint64_t key)
+{
+    VALIDATE_VECTOR(cv);
+    uint64_t buf[COMPVEC_BLOCK];
+    const uint64_t *firsts = (const uint64_t *)cv->firsts->data;
+    size_t lo = 0, hi = cv->blocks->len;
+    /* first block whose first value is not less than key, the answer is in it or at the end of the block before */
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (firsts[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    size_t block = lo ? lo - 1 : 0;
+    for (; block <= cv->blocks->len; block++)
+    {
+        size_t n = compvec_decode_block(cv, block, buf), i;
+        for (i = 0; i < n; i++)
+            if (buf[i] >= key)
+                return block * COMPVEC_BLOCK + i;
+    }
+    return cv->len;
+}
+
+CompVecIter compvec_iter(CompVec *cv)
+{
+    VALIDATE_VECTOR(cv);
+    CompVecIter it;
+    it.cv = cv;
+    it.idx = 0;
+    it.block = (size_t)-1;
+    return it;
+}
+
+int compvec_iter_next(CompVecIter *it, uint64_t *out)
+{
+    if (it->idx >= it->cv->len)
+        return 0;
+    size_t block = it->idx / COMPVEC_BLOCK;
+    if (block != it->block)
+    {
+        compvec_decode_block(it->cv, block, it->buf);
+        it->block = block;
+    }
+    *out = it->buf[it->idx % COMPVEC_BLOCK];
+    it->idx++;
+    return 1;
+}
+
+CompVec *compvec_from_vec(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    if (v->elem_size != sizeof(uint64_t))
+        return NULL;
+    CompVec *cv = compvec_new();
+    size_t i;
+    for (i = 0; i < v->len; i++)
+    {
+        uint64_t value;
+        memcpy(&value, vec_at(v, i), sizeof(value));
+        if (compvec_push(cv, value))
+        {
+            compvec_free(cv);
+            return NULL;
+        }
+    }
+    return cv;
+}
+
+Vec *compvec_to_vec(CompVec *cv)
+{
+    VALIDATE_VECTOR(cv);
+    Vec *v = vec_new(cv->len, sizeof(uint64_t), vec_ull_cmp, NULL, NULL);
+    size_t block, nblocks = cv->blocks->len;
+    for (block = 0; block <= nblocks && v->len < cv->len; block++)
+    {
+        uint64_t *dst = (uint64_t *)v->data + v->len;
+        v->len += compvec_decode_block(cv, block, dst);
+    }
+    return v;
+}
+
+size_t compvec_bytes(CompVec *cv)
+{
+    VALIDATE_VECTOR(cv);
+    return sizeof(CompVec) + cv->firsts->capacity * cv->firsts->elem_size + cv->blocks->capacity * cv->blocks->elem_size +
+           cv->packed->capacity * cv->packed->elem_size;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file compressed vector.h
+ * @brief Append mostly vector of non decreasing 64 bit integers, delta and bit packed in blocks.
+ *
+ * @details Values are grouped in blocks of COMPVEC_BLOCK. A sealed block keeps its first value in a skip index
+ * and the differences between neighbours minus their minimum (frame of reference), packed at the fewest bits
+ * that fit the largest of them. Sorted ID lists with small gaps shrink to a few bits per value.
+ * The last, unsealed block is kept plain so appends are cheap.
+ * Link compressed vector.c and vector.c.
+ */
+
+#ifndef COMPRESSED_VECTOR_H_
+#define COMPRESSED_VECTOR_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "vector.h"
+
+#define COMPVEC_BLOCK 128
+
+    typedef struct CompVecBlock
+    {
+        uint64_t base;  /* smallest difference in the block, added back to every packed value */
+        size_t word;    /* index into packed of the first word of the block */
+        uint8_t bits;   /* width of each packed difference, 0 when all differences equal base */
+    } CompVecBlock;
+
+    typedef struct CompVec
+    {
+        Vec *firsts; /* uint64_t first value of each sealed block, the skip index */
+        Vec *blocks; /* CompVecBlock per sealed block */
+        Vec *packed; /* uint64_t words of packed differences, always ends in one zero word */
+        uint64_t tail[COMPVEC_BLOCK]; /* values of the unsealed block */
+        size_t tail_len;
+        size_t len; /* total number of values */
+    } CompVec;
+
+    /**
+     * @brief Cursor for compvec_iter_next, decodes a block at a time.
+     *
+     */
+    typedef struct CompVecIter
+    {
+        CompVec *cv;
+        size_t idx;
+        size_t block; /* block currently decoded into buf, (size_t)-1 for none */
+        uint64_t buf[COMPVEC_BLOCK];
+    } CompVecIter;
+
+    /**
+     * @brief Creates an empty compressed vector.
+     *
+     * @return CompVec*
+     */
+    CompVec *compvec_new(void);
+
+    /**
+     * @brief Frees the compressed vector.
+     *
+     * @param cv Compressed vector to free.
+     */
+    void compvec_free(CompVec *cv);
+
+    /**
+     * @brief Appends a value.
+     *
+     * @param cv Compressed vector to append to.
+     * @param value Must not be less than the last value.
+     * @return int 0 on success, 1 when value is less than the last value and nothing was appended.
+     */
+    int compvec_push(CompVec *cv, uint64_t value);
+
+    /**
+     * @brief Returns the value at idx, decoding at most one block prefix.
+     *
+     * @param cv Compressed vector to read.
+     * @param idx Index of the value.
+     * @return uint64_t 0 when idx is out of bounds.
+     */
+    uint64_t compvec_at(CompVec *cv, size_t idx);
+
+    /**
+     * @brief Returns the index of the first value not less than key.
+     *
+     * @param cv Compressed vector to search.
+     * @param key Value to look for.
+     * @return size_t len when every value is less than key.
+     *
+     * @details Binary searches the skip index, then decodes the one block that can hold key.
+     */
+    size_t compvec_lower_bound(CompVec *cv, uint64_t key);
+
+    /**
+     * @brief Decodes the whole block containing idx.
+     *
+     * @param cv Compressed vector to read.
+     * @param block Index of the block, idx / COMPVEC_BLOCK.
+     * @param out Receives up to COMPVEC_BLOCK values.
+     * @return size_t Number of values written, 0 when block is out of bounds.
+     */
+    size_t compvec_decode_block(CompVec *cv, size_t block, uint64_t *out);
+
+    /**
+     * @brief Starts an iteration from the first value.
+     *
+     */
+    CompVecIter compvec_iter(CompVec *cv);
+
+    /**
+     * @brief Writes the next value to out.
+     *
+     * @param it Cursor from compvec_iter.
+     * @param out Receives the value.
+     * @return int 1 when a value was written, 0 at the end.
+     */
+    int compvec_iter_next(CompVecIter *it, uint64_t *out);
+
+    /**
+     * @brief Builds a compressed vector from a Vec of 8 byte unsigned integers.
+     *
+     * @param v Vector sorted with vec_ull_cmp.
+     * @return CompVec* NULL when elem_size is not 8 or the values are not sorted.
+     */
+    CompVec *compvec_from_vec(Vec *v);
+
+    /**
+     * @brief Decodes every value into a new Vec using vec_ull_cmp.
+     *
+     * @param cv Compressed vector to decode.
+     * @return Vec*
+     */
+    Vec *compvec_to_vec(CompVec *cv);
+
+    /**
+     * @brief Returns the bytes held by the compressed vector, for comparing with len * 8.
+     *
+     */
+    size_t compvec_bytes(CompVec *cv);
+
+#ifdef __cplusplus
+} /* Extern "C" */
+#endif
+
+#endif /* COMPRESSED_VECTOR_H_ */
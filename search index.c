@@ -0,0 +1,217 @@
+#include "search index.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SEARCH_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define SEARCH_PREFETCH(p) ((void)(p))
+#endif
+
+/* queries walked down the tree together by the batch search */
+#define SEARCH_BATCH 16
+
+enum
+{
+    SEARCH_GENERIC,
+    SEARCH_INT,
+    SEARCH_UINT,
+    SEARCH_LL,
+    SEARCH_ULL,
+};
+
+#define RANK(idx, k) (((size_t *)(idx)->rank->data)[k])
+
+/* fills the tree in order, so an in order walk of the implicit tree visits the sorted elements */
+static void search_fill(VecSearchIndex *idx, Vec *v, size_t k, size_t *next)
+{
+    if (k > idx->len)
+        return;
+    search_fill(idx, v, 2 * k, next);
+    memcpy(vec_at(idx->tree, k), vec_at(v, *next), v->elem_size);
+    RANK(idx, k) = *next;
+    (*next)++;
+    search_fill(idx, v, 2 * k + 1, next);
+}
+
+VecSearchIndex *vec_build_search_index(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    if (!v->cmp)
+    {
+        perror("vec_build_search_index: Compare function is undefined.");
+        return NULL;
+    }
+    size_t i;
+    for (i = 1; i < v->len; i++)
+        if (v->cmp(vec_at(v, i - 1), vec_at(v, i)) > 0)
+            return NULL;
+
+    VecSearchIndex *idx = malloc(sizeof(VecSearchIndex));
+    VEC_ASSERT(idx);
+    /* slot 0 is unused, which puts the 16 grandchildren of every node on a 64 byte line for 4 byte elements */
+    *idx = (VecSearchIndex){.tree = vec_new_aligned(v->len + 1, v->elem_size, VEC_CACHE_LINE, v->cmp, NULL, NULL),
+                            .rank = vec_new(v->len + 1, sizeof(size_t), NULL, NULL, NULL),
+                            .len = v->len,
+                            .cmp = v->cmp,
+                            .kind = SEARCH_GENERIC};
+    idx->tree->len = v->len + 1;
+    idx->rank->len = v->len + 1;
+    size_t next = 0;
+    search_fill(idx, v, 1, &next);
+    while (((size_t)2 << idx->depth) - 1 <= idx->len)
+        idx->depth++;
+
+    if (v->cmp == vec_int_cmp && v->elem_size == sizeof(int))
+        idx->kind = SEARCH_INT;
+    else if (v->cmp == vec_uint_cmp && v->elem_size == sizeof(unsigned int))
+        idx->kind = SEARCH_UINT;
+    else if (v->cmp == vec_ll_cmp && v->elem_size == sizeof(long long))
+        idx->kind = SEARCH_LL;
+    else if (v->cmp == vec_ull_cmp && v->elem_size == sizeof(unsigned long long))
+        idx->kind = SEARCH_ULL;
+    return idx;
+}
+
+void vec_search_index_free(VecSearchIndex *idx)
+{
+    VALIDATE_VECTOR(idx);
+    vec_free(idx->tree);
+    vec_free(idx->rank);
+    free(idx);
+}
+
+/* a search ends below a leaf, going right at every compare that was less then once left at the answer.
+    Dropping the trailing right turns and that left turn gives the answer, 0 when there is none */
+static size_t search_finish(VecSearchIndex *idx, size_t k)
+{
+    while (k & 1)
+        k >>= 1;
+    k >>= 1;
+    return k ? RANK(idx, k) : idx->len;
+}
+
+/* single and batched searches over a tree of T compared with < */
+#define SEARCH_TYPED(name, T)                                                                          \
+    static size_t name(VecSearchIndex *idx, const void *keyp)                                          \
+    {                                                                                                  \
+        const T *t = (const T *)idx->tree->data;                                                       \
+        size_t n = idx->len, k = 1;                                                                    \
+        T key;                                                                                         \
+        memcpy(&key, keyp, sizeof(T));                                                                 \
+        while (k <= n)                                                                                 \
+        {                                                                                              \
+            if (16 * k <= n)                                                                           \
+                SEARCH_PREFETCH(t + 16 * k);                                                           \
+            k = 2 * k + (t[k] < key);                                                                  \
+        }                                                                                              \
+        return k;                                                                                      \
+    }                                                                                                  \
+    static void name##_batch(VecSearchIndex *idx, const void *keysp, size_t count, size_t *out)        \
+    {                                                                                                  \
+        const T *t = (const T *)idx->tree->data;                                                       \
+        size_t n = idx->len, base, level, j;                                                           \
+        for (base = 0; base < count; base += SEARCH_BATCH)                                             \
+        {                                                                                              \
+            size_t g = count - base < SEARCH_BATCH ? count - base : SEARCH_BATCH;                      \
+            size_t ks[SEARCH_BATCH];                                                                   \
+            T keys[SEARCH_BATCH];                                                                      \
+            memcpy(keys, (const T *)keysp + base, g * sizeof(T));                                      \
+            for (j = 0; j < g; j++)                                                                    \
+                ks[j] = 1;                                                                             \
+            /* the complete levels exist for every key, so the group steps without bound checks */    \
+            for (level = 0; level < idx->depth; level++)                                               \
+            {                                                                                          \
+                for (j = 0; j < g; j++)                                                                \
+                {                                                                                      \
+                    if (16 * ks[j] <= n)                                                               \
+                        SEARCH_PREFETCH(t + 16 * ks[j]);                                               \
+                    ks[j] = 2 * ks[j] + (t[ks[j]] < keys[j]);                                          \
+                }                                                                                      \
+            }                                                                                          \
+            for (j = 0; j < g; j++)                                                                    \
+            {                                                                                          \
+                if (ks[j] <= n)                                                                        \
+                    ks[j] = 2 * ks[j] + (t[ks[j]] < keys[j]);                                          \
+                out[base + j] = search_finish(idx, ks[j]);                                             \
+            }                                                                                          \
+        }                                                                                              \
+    }
+
+SEARCH_TYPED(search_int, int)
+SEARCH_TYPED(search_uint, unsigned int)
+SEARCH_TYPED(search_ll, long long)
+SEARCH_TYPED(search_ull, unsigned long long)
+
+static size_t search_generic(VecSearchIndex *idx, const void *key)
+{
+    const byte *t = idx->tree->data;
+    size_t es = idx->tree->elem_size, n = idx->len, k = 1;
+    while (k <= n)
+    {
+        if (16 * k <= n)
+            SEARCH_PREFETCH(t + 16 * k * es);
+        k = 2 * k + (idx->cmp(t + k * es, key) < 0);
+    }
+    return k;
+}
+
+static size_t search_descend(VecSearchIndex *idx, const void *key)
+{
+    switch (idx->kind)
+    {
+    case SEARCH_INT:
+        return search_int(idx, key);
+    case SEARCH_UINT:
+        return search_uint(idx, key);
+    case SEARCH_LL:
+        return search_ll(idx, key);
+    case SEARCH_ULL:
+        return search_ull(idx, key);
+    default:
+        return search_generic(idx, key);
+    }
+}
+
+size_t vec_search_index_lower_bound(VecSearchIndex *idx, const void *key)
+{
+    VALIDATE_VECTOR(idx);
+    return search_finish(idx, search_descend(idx, key));
+}
+
+int vec_search_index_contains(VecSearchIndex *idx, const void *key)
+{
+    VALIDATE_VECTOR(idx);
+    size_t k = search_descend(idx, key);
+    while (k & 1)
+        k >>= 1;
+    k >>= 1;
+    return k && idx->cmp(vec_at(idx->tree, k), key) == 0;
+}
+
+void vec_search_index_lower_bound_batch(VecSearchIndex *idx, const void *keys, size_t count, size_t *out)
+{
+    VALIDATE_VECTOR(idx);
+    size_t i;
+    switch (idx->kind)
+    {
+    case SEARCH_INT:
+        search_int_batch(idx, keys, count, out);
+        return;
+    case SEARCH_UINT:
+        search_uint_batch(idx, keys, count, out);
+        return;
+    case SEARCH_LL:
+        search_ll_batch(idx, keys, count, out);
+        return;
+    case SEARCH_ULL:
+        search_ull_batch(idx, keys, count, out);
+        return;
+    default:
+        /* a call per compare hides little latency, search one key at a time */
+        for (i = 0; i < count; i++)
+            out[i] = search_finish(idx, search_generic(idx, (const byte *)keys + i * idx->tree->elem_size));
+        return;
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * @file search index.h
+ * @brief Immutable copy of a sorted Vec in Eytzinger (breadth first) order for cache friendly searches.
+ *
+ * @details Binary search over a sorted array touches a new cache line on almost every probe.
+ * The Eytzinger layout stores the search tree level by level, so the first levels share a few hot lines
+ * and the 16 grandchildren four levels below any node are adjacent, which lets each step prefetch
+ * the lines it will need four steps later. Vectors using the built in int, uint, ll and ull comparators
+ * get typed search loops that compare inline instead of calling cmp.
+ * Link search index.c and vector.c.
+ */
+
+#ifndef SEARCH_INDEX_H_
+#define SEARCH_INDEX_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "vector.h"
+
+    typedef struct VecSearchIndex
+    {
+        Vec *tree;    /* elements in Eytzinger order, 1 based so index 0 is unused */
+        Vec *rank;    /* size_t position in the sorted vector of each tree slot */
+        size_t len;   /* number of elements */
+        size_t depth; /* levels that are complete, every search takes depth or depth + 1 steps */
+        void_cmp_func cmp;
+        int kind; /* typed search loop, 0 for the generic cmp one */
+    } VecSearchIndex;
+
+    /**
+     * @brief Builds a search index from a vector sorted with its cmp.
+     *
+     * @param v Sorted vector, it is copied and may change or be freed afterwards.
+     * @return VecSearchIndex* NULL when v has no cmp or is not sorted.
+     */
+    VecSearchIndex *vec_build_search_index(Vec *v);
+
+    /**
+     * @brief Frees the search index.
+     *
+     * @param idx Search index to free.
+     */
+    void vec_search_index_free(VecSearchIndex *idx);
+
+    /**
+     * @brief Returns the position in the sorted vector of the first element not less than key.
+     *
+     * @param idx Search index to query.
+     * @param key Element to look for.
+     * @return size_t len when every element is less than key.
+     */
+    size_t vec_search_index_lower_bound(VecSearchIndex *idx, const void *key);
+
+    /**
+     * @brief Returns 1 when an element equal to key is in the index, 0 otherwise.
+     *
+     */
+    int vec_search_index_contains(VecSearchIndex *idx, const void *key);
+
+    /**
+     * @brief Runs vec_search_index_lower_bound for count keys, walking groups of them down the tree in step.
+     *
+     * @param idx Search index to query.
+     * @param keys count elements of elem_size bytes, one after the other.
+     * @param count Number of keys.
+     * @param out Receives count positions.
+     *
+     * @details Interleaving independent searches lets their cache misses overlap instead of being paid one after another.
+     */
+    void vec_search_index_lower_bound_batch(VecSearchIndex *idx, const void *keys, size_t count, size_t *out);
+
+#ifdef __cplusplus
+} /* Extern "C" */
+#endif
+
+#endif /* SEARCH_INDEX_H_ */
@@ -0,0 +1,147 @@
+#include "slot map.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define SLOT_NONE UINT32_MAX
+#define SLOT(sm, i) ((SlotMapSlot *)vec_at((sm)->slots, i))
+#define DENSE_SLOT(sm, i) (*(uint32_t *)vec_at((sm)->dense_slot, i))
+#define HANDLE(gen, idx) (((SlotHandle)(gen) << 32) | (SlotHandle)(idx))
+#define HANDLE_GEN(h) ((uint32_t)((h) >> 32))
+#define HANDLE_IDX(h) ((uint32_t)(h))
+
+SlotMap *slotmap_new(size_t capacity, size_t elem_size)
+{
+    SlotMap *sm = malloc(sizeof(SlotMap));
+    VEC_ASSERT(sm);
+    *sm = (SlotMap){.dense = vec_new(capacity, elem_size, NULL, NULL, NULL),
+                    .dense_slot = vec_new(capacity, sizeof(uint32_t), NULL, NULL, NULL),
+                    .slots = vec_new(capacity, sizeof(SlotMapSlot), NULL, NULL, NULL),
+                    .free_head = SLOT_NONE};
+    return sm;
+}
+
+void slotmap_free(SlotMap *sm)
+{
+    VALIDATE_VECTOR(sm);
+    vec_free(sm->dense);
+    vec_free(sm->dense_slot);
+    vec_free(sm->slots);
+    free(sm);
+}
+
+/* the slot of a live handle, NULL when the handle is stale, invalid or out of bounds */
+static SlotMapSlot *slotmap_lookup(SlotMap *sm, SlotHandle h)
+{
+    uint32_t idx = HANDLE_IDX(h);
+    if (h == SLOTMAP_INVALID || idx >= sm->slots->len)
+        return NULL;
+    SlotMapSlot *s = SLOT(sm, idx);
+    /* a free slot links to another slot, which never owns a dense entry pointing back here */
+    if (s->gen != HANDLE_GEN(h) || s->idx >= sm->dense->len || DENSE_SLOT(sm, s->idx) != idx)
+        return NULL;
+    return s;
+}
+
+SlotHandle slotmap_insert(SlotMap *sm, const void *data)
+{
+    VALIDATE_VECTOR(sm);
+    uint32_t idx;
+    SlotMapSlot *s;
+    if (sm->free_head != SLOT_NONE)
+    {
+        idx = sm->free_head;
+        s = SLOT(sm, idx);
+        sm->free_head = s->idx;
+    }
+    else
+    {
+        VEC_ASSERT(sm->slots->len < SLOT_NONE && "slotmap_insert: Out of slot indices.");
+        SlotMapSlot fresh = {.idx = 0, .gen = 1};
+        idx = (uint32_t)sm->slots->len;
+        vec_push_back(sm->slots, &fresh);
+        s = SLOT(sm, idx);
+    }
+    s->idx = (uint32_t)sm->dense->len;
+    vec_push_back(sm->dense, (void *)data);
+    vec_push_back(sm->dense_slot, &idx);
+    return HANDLE(s->gen, idx);
+}
+
+void *slotmap_get(SlotMap *sm, SlotHandle h)
+{
+    VALIDATE_VECTOR(sm);
+    SlotMapSlot *s = slotmap_lookup(sm, h);
+    if (!s)
+        return NULL;
+    return vec_at(sm->dense, s->idx);
+}
+
+int slotmap_contains(SlotMap *sm, SlotHandle h)
+{
+    VALIDATE_VECTOR(sm);
+    return slotmap_lookup(sm, h) != NULL;
+}
+
+int slotmap_remove(SlotMap *sm, SlotHandle h)
+{
+    VALIDATE_VECTOR(sm);
+    SlotMapSlot *s = slotmap_lookup(sm, h);
+    if (!s)
+        return 1;
+    uint32_t hole = s->idx, last = (uint32_t)sm->dense->len - 1;
+    if (hole != last)
+    {
+        /* the slot of the last element follows it into the hole */
+        SLOT(sm, DENSE_SLOT(sm, last))->idx = hole;
+    }
+    vec_remove_fast(sm->dense, hole);
+    vec_remove_fast(sm->dense_slot, hole);
+
+    /* generation 0 would make the handle of slot 0 equal SLOTMAP_INVALID */
+    s->gen = s->gen == UINT32_MAX ? 1 : s->gen + 1;
+    s->idx = sm->free_head;
+    sm->free_head = HANDLE_IDX(h);
+    return 0;
+}
+
+void slotmap_clear(SlotMap *sm)
+{
+    VALIDATE_VECTOR(sm);
+    size_t i;
+    for (i = 0; i < sm->dense_slot->len; i++)
+    {
+        SlotMapSlot *s = SLOT(sm, DENSE_SLOT(sm, i));
+        s->gen = s->gen == UINT32_MAX ? 1 : s->gen + 1;
+    }
+    /* relink every slot so the lowest indices are reused first */
+    sm->free_head = SLOT_NONE;
+    for (i = sm->slots->len; i > 0; i--)
+    {
+        SLOT(sm, i - 1)->idx = sm->free_head;
+        sm->free_head = (uint32_t)(i - 1);
+    }
+    vec_clear(sm->dense);
+    vec_clear(sm->dense_slot);
+}
+
+size_t slotmap_size(SlotMap *sm)
+{
+    VALIDATE_VECTOR(sm);
+    return sm->dense->len;
+}
+
+Vec *slotmap_dense(SlotMap *sm)
+{
+    VALIDATE_VECTOR(sm);
+    return sm->dense;
+}
+
+SlotHandle slotmap_handle_at(SlotMap *sm, size_t idx)
+{
+    VALIDATE_VECTOR(sm);
+    if (idx >= sm->dense->len)
+        return SLOTMAP_INVALID;
+    uint32_t slot = DENSE_SLOT(sm, idx);
+    return HANDLE(SLOT(sm, slot)->gen, slot);
+}
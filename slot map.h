@@ -0,0 +1,127 @@
+/**
+ * @file slot map.h
+ * @brief Dense Vec of elements addressed through stable generational handles.
+ *
+ * @details Removing swaps the last element into the hole like vec_remove_fast, so the elements stay packed
+ * for iteration, but callers hold handles instead of indices. A handle names a slot and the generation
+ * the slot had when the element was inserted, every removal bumps the generation so stale handles are detected.
+ * Link slot map.c and vector.c.
+ */
+
+#ifndef SLOT_MAP_H_
+#define SLOT_MAP_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "vector.h"
+
+    /* generation << 32 | slot index, 0 is never handed out */
+    typedef uint64_t SlotHandle;
+
+#define SLOTMAP_INVALID ((SlotHandle)0)
+
+    typedef struct SlotMapSlot
+    {
+        uint32_t idx; /* index into dense while the slot is used, next free slot otherwise */
+        uint32_t gen; /* starts at 1, bumped on removal */
+    } SlotMapSlot;
+
+    typedef struct SlotMap
+    {
+        Vec *dense;      /* the elements, packed */
+        Vec *dense_slot; /* uint32_t slot index owning each element of dense */
+        Vec *slots;      /* SlotMapSlot */
+        uint32_t free_head; /* first free slot, UINT32_MAX when every slot is used */
+    } SlotMap;
+
+    /**
+     * @brief Creates an empty slot map.
+     *
+     * @param capacity Number of elements to reserve space for.
+     * @param elem_size Size of each element in bytes.
+     * @return SlotMap*
+     */
+    SlotMap *slotmap_new(size_t capacity, size_t elem_size);
+
+    /**
+     * @brief Frees the slot map.
+     *
+     * @param sm Slot map to free.
+     */
+    void slotmap_free(SlotMap *sm);
+
+    /**
+     * @brief Copies an element in and returns its handle.
+     *
+     * @param sm Slot map to insert into.
+     * @param data Element to copy.
+     * @return SlotHandle Valid until the element is removed.
+     */
+    SlotHandle slotmap_insert(SlotMap *sm, const void *data);
+
+    /**
+     * @brief Returns the element of a handle.
+     *
+     * @param sm Slot map to read.
+     * @param h Handle from slotmap_insert.
+     * @return void* NULL when the handle is stale or invalid. Valid until the next insert or remove.
+     */
+    void *slotmap_get(SlotMap *sm, SlotHandle h);
+
+    /**
+     * @brief Returns 1 when the handle names a live element, 0 otherwise.
+     *
+     */
+    int slotmap_contains(SlotMap *sm, SlotHandle h);
+
+    /**
+     * @brief Removes the element of a handle in O(1), the last element moves into its place.
+     *
+     * @param sm Slot map to remove from.
+     * @param h Handle from slotmap_insert.
+     * @return int 0 on success, 1 when the handle is stale or invalid.
+     *
+     * @details Every other handle stays valid.
+     */
+    int slotmap_remove(SlotMap *sm, SlotHandle h);
+
+    /**
+     * @brief Removes every element, all outstanding handles become stale.
+     *
+     * @param sm Slot map to clear.
+     */
+    void slotmap_clear(SlotMap *sm);
+
+    /**
+     * @brief Returns the number of elements.
+     *
+     */
+    size_t slotmap_size(SlotMap *sm);
+
+    /**
+     * @brief Returns the packed elements for iteration, for example with V_FOR_EACH_FAST.
+     *
+     * @param sm Slot map to read.
+     * @return Vec*
+     *
+     * @warning The elements may be read or written in place, but must not be added or removed through the Vec.
+     */
+    Vec *slotmap_dense(SlotMap *sm);
+
+    /**
+     * @brief Returns the handle of the element at index idx of slotmap_dense.
+     *
+     * @param sm Slot map to read.
+     * @param idx Index into the dense elements.
+     * @return SlotHandle SLOTMAP_INVALID when idx is out of bounds.
+     */
+    SlotHandle slotmap_handle_at(SlotMap *sm, size_t idx);
+
+#ifdef __cplusplus
+} /* Extern "C" */
+#endif
+
+#endif /* SLOT_MAP_H_ */
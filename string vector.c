@@ -0,0 +1,146 @@
+#include "string vector.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define ENTRY(sv, idx) ((StrVecEntry *)vec_at((sv)->entries, idx))
+
+StrVec *strvec_new(size_t capacity, size_t blob_capacity)
+{
+    StrVec *sv = malloc(sizeof(StrVec));
+    VEC_ASSERT(sv);
+    *sv = (StrVec){.blob = vec_new(blob_capacity, sizeof(char), NULL, NULL, NULL),
+                   .entries = vec_new(capacity, sizeof(StrVecEntry), NULL, NULL, NULL)};
+    /* nothing past len is ever read, so clear and free skip the memset */
+    sv->blob->flags |= VEC_FLAG_NO_ZERO;
+    sv->entries->flags |= VEC_FLAG_NO_ZERO;
+    return sv;
+}
+
+void strvec_free(StrVec *sv)
+{
+    VALIDATE_VECTOR(sv);
+    vec_free(sv->blob);
+    vec_free(sv->entries);
+    free(sv);
+}
+
+void strvec_push(StrVec *sv, const char *str)
+{
+    VALIDATE_VECTOR(sv);
+    if (!str)
+        return;
+    strvec_push_n(sv, str, strlen(str));
+}
+
+void strvec_push_n(StrVec *sv, const void *data, size_t len)
+{
+    VALIDATE_VECTOR(sv);
+    if (!data && len)
+        return;
+    StrVecEntry e = {.off = sv->blob->len, .len = len};
+    char nul = '\0';
+    /* vec_insert_n copies data aside first when it points into the blob */
+    vec_insert_n(sv->blob, sv->blob->len, data, len);
+    vec_push_back(sv->blob, &nul);
+    vec_push_back(sv->entries, &e);
+}
+
+const char *strvec_at(StrVec *sv, size_t idx)
+{
+    VALIDATE_VECTOR(sv);
+    if (idx >= sv->entries->len)
+        return NULL;
+    return (const char *)vec_at(sv->blob, ENTRY(sv, idx)->off);
+}
+
+size_t strvec_len_at(StrVec *sv, size_t idx)
+{
+    VALIDATE_VECTOR(sv);
+    if (idx >= sv->entries->len)
+        return 0;
+    return ENTRY(sv, idx)->len;
+}
+
+size_t strvec_size(StrVec *sv)
+{
+    VALIDATE_VECTOR(sv);
+    return sv->entries->len;
+}
+
+size_t strvec_find(StrVec *sv, const char *str)
+{
+    VALIDATE_VECTOR(sv);
+    if (!str)
+        return INVALID_FE_IDX;
+    size_t len = strlen(str), i;
+    for (i = 0; i < sv->entries->len; i++)
+    {
+        StrVecEntry *e = ENTRY(sv, i);
+        if (e->len == len && memcmp(sv->blob->data + e->off, str, len) == 0)
+            return i;
+    }
+    return INVALID_FE_IDX;
+}
+
+static int strvec_entry_cmp(const byte *blob, const StrVecEntry *ea, const StrVecEntry *eb)
+{
+    size_t n = ea->len < eb->len ? ea->len : eb->len;
+    int c = memcmp(blob + ea->off, blob + eb->off, n);
+    if (c)
+        return c;
+    return (ea->len > eb->len) - (ea->len < eb->len);
+}
+
+/* bottom up merge sort of entry indices, the comparisons read the bytes through the blob, returns the sorted buffer */
+static size_t *strvec_merge_sort(StrVec *sv, size_t *idx, size_t *tmp, size_t n)
+{
+    const byte *blob = sv->blob->data;
+    const StrVecEntry *entries = (const StrVecEntry *)sv->entries->data;
+    size_t width, lo, *src = idx, *dst = tmp, *swap;
+    for (width = 1; width < n; width *= 2)
+    {
+        for (lo = 0; lo < n; lo += 2 * width)
+        {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t a = lo, b = mid, k = lo;
+            while (a < mid && b < hi)
+                dst[k++] = strvec_entry_cmp(blob, &entries[src[b]], &entries[src[a]]) < 0 ? src[b++] : src[a++];
+            while (a < mid)
+                dst[k++] = src[a++];
+            while (b < hi)
+                dst[k++] = src[b++];
+        }
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+    return src;
+}
+
+void strvec_sort(StrVec *sv)
+{
+    VALIDATE_VECTOR(sv);
+    size_t n = sv->entries->len, i;
+    if (n < 2)
+        return;
+    /* two index buffers for the merge passes, then the entries in their new order */
+    size_t *idx = malloc(2 * n * sizeof(size_t) + n * sizeof(StrVecEntry));
+    VEC_ASSERT(idx && "strvec_sort: Failed to allocate the index buffers.");
+    StrVecEntry *sorted = (StrVecEntry *)(idx + 2 * n);
+    for (i = 0; i < n; i++)
+        idx[i] = i;
+    size_t *order = strvec_merge_sort(sv, idx, idx + n, n);
+    for (i = 0; i < n; i++)
+        sorted[i] = *ENTRY(sv, order[i]);
+    memcpy(sv->entries->data, sorted, n * sizeof(StrVecEntry));
+    free(idx);
+}
+
+void strvec_clear(StrVec *sv)
+{
+    VALIDATE_VECTOR(sv);
+    vec_clear(sv->blob);
+    vec_clear(sv->entries);
+}
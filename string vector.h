@@ -0,0 +1,121 @@
+/**
+ * @file string vector.h
+ * @brief Vector of strings and byte blobs packed into one contiguous pool.
+ *
+ * @details Replaces a Vec of char * with vec_deref_free: the bytes of every string go into one growing blob
+ * and a second Vec keeps the offset and length of each, so pushing does not call malloc per string
+ * and clearing or freeing is O(1). Every entry is followed by a NUL byte, so strvec_at can be passed to C string functions.
+ * Link string vector.c and vector.c.
+ */
+
+#ifndef STRING_VECTOR_H_
+#define STRING_VECTOR_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "vector.h"
+
+    typedef struct StrVecEntry
+    {
+        size_t off; /* offset of the first byte in blob */
+        size_t len; /* length without the NUL */
+    } StrVecEntry;
+
+    typedef struct StrVec
+    {
+        Vec *blob;    /* bytes of every entry, each followed by a NUL */
+        Vec *entries; /* StrVecEntry per string */
+    } StrVec;
+
+    /**
+     * @brief Creates an empty string vector.
+     *
+     * @param capacity Number of strings to reserve space for.
+     * @param blob_capacity Number of bytes to reserve for their contents.
+     * @return StrVec*
+     */
+    StrVec *strvec_new(size_t capacity, size_t blob_capacity);
+
+    /**
+     * @brief Frees the string vector, all strings are released at once.
+     *
+     * @param sv String vector to free.
+     */
+    void strvec_free(StrVec *sv);
+
+    /**
+     * @brief Copies a NUL terminated string into the vector.
+     *
+     * @param sv String vector to push into.
+     * @param str String to copy, may point into sv. NULL pushes nothing.
+     */
+    void strvec_push(StrVec *sv, const char *str);
+
+    /**
+     * @brief Copies len bytes into the vector, the bytes may contain NULs.
+     *
+     * @param sv String vector to push into.
+     * @param data Bytes to copy, may point into sv. NULL pushes nothing unless len is 0, which pushes an empty entry.
+     * @param len Number of bytes.
+     */
+    void strvec_push_n(StrVec *sv, const void *data, size_t len);
+
+    /**
+     * @brief Returns the entry at idx.
+     *
+     * @param sv String vector to read.
+     * @param idx Index of the entry.
+     * @return const char* NUL terminated, NULL when idx is out of bounds. Valid until the next push.
+     */
+    const char *strvec_at(StrVec *sv, size_t idx);
+
+    /**
+     * @brief Returns the length in bytes of the entry at idx, not counting the NUL.
+     *
+     * @param sv String vector to read.
+     * @param idx Index of the entry.
+     * @return size_t 0 when idx is out of bounds.
+     */
+    size_t strvec_len_at(StrVec *sv, size_t idx);
+
+    /**
+     * @brief Returns the number of entries.
+     *
+     * @param sv String vector to read.
+     * @return size_t
+     */
+    size_t strvec_size(StrVec *sv);
+
+    /**
+     * @brief Returns the index of the first entry equal to str.
+     *
+     * @param sv String vector to search.
+     * @param str NUL terminated string to look for.
+     * @return size_t INVALID_FE_IDX when there is none.
+     */
+    size_t strvec_find(StrVec *sv, const char *str);
+
+    /**
+     * @brief Sorts the entries by their bytes, shorter first when one is a prefix of the other.
+     *
+     * @param sv String vector to sort.
+     *
+     * @details Only the entries are reordered, the blob stays where it is. Equal strings keep their order.
+     */
+    void strvec_sort(StrVec *sv);
+
+    /**
+     * @brief Removes every entry in O(1).
+     *
+     * @param sv String vector to clear.
+     */
+    void strvec_clear(StrVec *sv);
+
+#ifdef __cplusplus
+} /* Extern "C" */
+#endif
+
+#endif /* STRING_VECTOR_H_ */
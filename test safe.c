@@ -0,0 +1,121 @@
+/*
+    Tests for the error returning vector (vector safe.h). It defines the same symbols as vector.c,
+    so it is built on its own:
+        cc "test safe.c" "vector safe.c" "vector budget.c" -o test_safe
+        cc -DVEC_ENABLE_BUDGET "test safe.c" "vector safe.c" "vector budget.c" -o test_safe
+*/
+#include "vector safe.h"
+#include <string.h>
+#define CTF_TEST_NAMES
+#include "../Testing/ctf.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+TEST_MAKE(Reverse_Vec)
+{
+    Vec v;
+    byte elem[3];
+    size_t i, n;
+    for (n = 0; n < 8; n++)
+    {
+        TEST_ASSERT_CLEAN(vec_new(&v, 10, sizeof(elem), NULL, NULL, NULL) == NONE, (void)0);
+        memset(v.data, 0xAB, v.capacity * v.elem_size);
+        for (i = 0; i < n; i++)
+        {
+            elem[0] = (byte)i;
+            elem[1] = (byte)(i + 100);
+            elem[2] = (byte)(i + 200);
+            TEST_ASSERT_CLEAN(vec_push_back(&v, elem) == NONE, vec_free(&v));
+        }
+        vec_reverse(&v);
+        /* whole elements swap places, the bytes inside an element keep their order */
+        for (i = 0; i < n; i++)
+        {
+            byte *e = vec_at(&v, i);
+            size_t from = n - 1 - i;
+            TEST_ASSERT_CLEAN(e[0] == (byte)from && e[1] == (byte)(from + 100) && e[2] == (byte)(from + 200), vec_free(&v));
+        }
+        /* the capacity past len is not touched */
+        for (i = n * v.elem_size; i < v.capacity * v.elem_size; i++)
+            TEST_ASSERT_CLEAN(v.data[i] == 0xAB, vec_free(&v));
+        vec_free(&v);
+    }
+    TEST_PASS();
+}
+
+TEST_MAKE(Append_Vec)
+{
+    Vec a, b;
+    int i;
+    TEST_ASSERT_CLEAN(vec_new(&a, 4, sizeof(int), NULL, NULL, NULL) == NONE, (void)0);
+    TEST_ASSERT_CLEAN(vec_new(&b, 4, sizeof(short), NULL, NULL, NULL) == NONE, vec_free(&a));
+    for (i = 0; i < 6; i++)
+        vec_push_back(&a, &i);
+    /* mismatched elements are refused, appending to itself doubles the contents */
+    TEST_ASSERT_CLEAN(vec_append(&a, &b) == UNKNOWN && a.len == 6, TEST_BLOCK(vec_free(&a); vec_free(&b)));
+    TEST_ASSERT_CLEAN(vec_append(&a, &a) == NONE && a.len == 12, TEST_BLOCK(vec_free(&a); vec_free(&b)));
+    for (i = 0; i < 12; i++)
+        TEST_ASSERT_CLEAN(*(int *)vec_at(&a, i) == i % 6, TEST_BLOCK(vec_free(&a); vec_free(&b)));
+    vec_free(&a);
+    vec_free(&b);
+    TEST_PASS();
+}
+
+#ifdef VEC_ENABLE_BUDGET
+static void count_soft_limit(VecBudget *budget, size_t requested, void *ctx)
+{
+    (void)budget;
+    (void)requested;
+    (*(int *)ctx)++;
+}
+
+TEST_MAKE(Budget_Vec)
+{
+    VecBudget group;
+    Vec v;
+    int soft_calls = 0, i;
+    size_t global_before = vec_budget_global()->bytes;
+    vec_budget_init(&group, "test", 200, 400);
+    group.on_soft_limit = count_soft_limit;
+    group.ctx = &soft_calls;
+
+    TEST_ASSERT_CLEAN(vec_new(&v, 10, sizeof(int), NULL, NULL, NULL) == NONE, (void)0);
+    TEST_ASSERT_CLEAN(vec_budget_global()->bytes == global_before + 40 && group.bytes == 0, vec_free(&v));
+    TEST_ASSERT_CLEAN(vec_set_budget(&v, &group) == NONE && group.bytes == 40, vec_free(&v));
+
+    /* 40, 80, 160 and 320 bytes fit, doubling to 640 is over the hard limit */
+    Vec_Error err = NONE;
+    for (i = 0; err == NONE; i++)
+        err = vec_push_back(&v, &i);
+    TEST_ASSERT_CLEAN(err == FAILED_ALLOC && v.len == 80 && v.capacity == 80, vec_free(&v));
+    TEST_ASSERT_CLEAN(group.bytes == 320 && group.peak == 320, vec_free(&v));
+    TEST_ASSERT_CLEAN(vec_budget_global()->bytes == global_before + 320, vec_free(&v));
+    /* crossing 200 on the way to 320 fired the callback, the failed charge did not fire it again */
+    TEST_ASSERT_CLEAN(soft_calls == 1, vec_free(&v));
+    /* the failed push left the vector intact */
+    for (i = 0; i < 80; i++)
+        TEST_ASSERT_CLEAN(*(int *)vec_at(&v, i) == i, vec_free(&v));
+
+    vec_free(&v);
+    TEST_ASSERT_CLEAN(group.bytes == 0 && group.peak == 320, (void)0);
+    TEST_ASSERT_CLEAN(vec_budget_global()->bytes == global_before, (void)0);
+    TEST_PASS();
+}
+#endif
+
+TEST_SUITE_MAKE(Safe_Vec)
+{
+    TEST_SUITE_INIT(Safe_Vec);
+    TEST_SUITE_LINK(Safe_Vec, Reverse_Vec);
+    TEST_SUITE_LINK(Safe_Vec, Append_Vec);
+#ifdef VEC_ENABLE_BUDGET
+    TEST_SUITE_LINK(Safe_Vec, Budget_Vec);
+#endif
+    TEST_SUITE_END(Safe_Vec);
+}
+
+int main()
+{
+    TEST_SUITE_RUN(Safe_Vec);
+    return 0;
+}
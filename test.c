@@ -1,4 +1,12 @@
 #include "vector.h"
+#include "vector soa.h"
+#include "bit vector.h"
+#include "string vector.h"
+#include "slot map.h"
+#include "compressed vector.h"
+#include "search index.h"
+#include "vector numeric.h"
+#include <string.h>
 #define CTF_TEST_NAMES
 #include "../Testing/ctf.h"
 #include <stdio.h>
@@ -100,6 +108,1072 @@ TEST_MAKE(Rev_Vec)
     TEST_PASS();
 }
 
+TEST_MAKE(Iter_Vec)
+{
+    Vec *int_vec = VEC(int);
+    int value, i, pairs = 0;
+    for (i = 0; i < 10; i++)
+    {
+        value = i;
+        V_ADD(int_vec, &value);
+    }
+    V_FOR_EACH_FAST(int_vec, int, outer)
+    {
+        V_FOR_EACH_FAST(int_vec, int, inner)
+        {
+            pairs++;
+        }
+    }
+    TEST_ASSERT_CLEAN(pairs == 100, vec_free(int_vec));
+
+    /* remove the odd entries while a second cursor walks the same vector */
+    VecIter it = vec_iter(int_vec);
+    int *cur;
+    V_ITER_EACH_ANSI(it, cur)
+    {
+        VecIter inner = vec_iter(int_vec);
+        int *other, seen = 0;
+        V_ITER_EACH_ANSI(inner, other)
+        {
+            seen++;
+        }
+        TEST_ASSERT_CLEAN(seen == (int)int_vec->len, vec_free(int_vec));
+        if (*cur % 2)
+            vec_iter_remove(&it);
+    }
+    TEST_ASSERT_CLEAN(int_vec->len == 5, vec_free(int_vec));
+    for (i = 0; i < 5; i++)
+    {
+        TEST_ASSERT_CLEAN(*(int *)vec_at(int_vec, i) == i * 2, vec_free(int_vec));
+    }
+    vec_free(int_vec);
+    TEST_PASS();
+}
+
+static int is_odd(const void *elem, void *ctx)
+{
+    (void)ctx;
+    return *(const int *)elem % 2;
+}
+
+TEST_MAKE(Remove_If_Vec)
+{
+    Vec *int_vec = VEC(int);
+    int value, i;
+    for (i = 0; i < 20; i++)
+    {
+        value = i;
+        V_ADD(int_vec, &value);
+    }
+    TEST_ASSERT_CLEAN(vec_remove_if(int_vec, is_odd, NULL) == 10, vec_free(int_vec));
+    for (i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_CLEAN(*(int *)vec_at(int_vec, i) == i * 2, vec_free(int_vec));
+    }
+    vec_remove_range(int_vec, 2, 3);
+    TEST_ASSERT_CLEAN(int_vec->len == 7, vec_free(int_vec));
+    TEST_ASSERT_CLEAN(*(int *)vec_at(int_vec, 1) == 2 && *(int *)vec_at(int_vec, 2) == 10, vec_free(int_vec));
+    TEST_ASSERT_CLEAN(vec_retain(int_vec, is_odd, NULL) == 7 && int_vec->len == 0, vec_free(int_vec));
+    vec_free(int_vec);
+    TEST_PASS();
+}
+
+TEST_MAKE(Insert_N_Vec)
+{
+    Vec *int_vec = VEC(int);
+    int values[25], i;
+    for (i = 0; i < 25; i++)
+        values[i] = 100 + i;
+    for (i = 0; i < 4; i++)
+        V_ADD(int_vec, &i);
+    vec_insert_n(int_vec, 2, values, 25);
+    TEST_ASSERT_CLEAN(int_vec->len == 29, vec_free(int_vec));
+    TEST_ASSERT_CLEAN(*(int *)vec_at(int_vec, 1) == 1 && *(int *)vec_at(int_vec, 27) == 2, vec_free(int_vec));
+    for (i = 0; i < 25; i++)
+    {
+        TEST_ASSERT_CLEAN(*(int *)vec_at(int_vec, i + 2) == 100 + i, vec_free(int_vec));
+    }
+    /* splicing a vector into itself */
+    TEST_ASSERT_CLEAN(vec_insert_vec(int_vec, 0, int_vec) == 0 && int_vec->len == 58, vec_free(int_vec));
+    TEST_ASSERT_CLEAN(*(int *)vec_at(int_vec, 28) == 3 && *(int *)vec_at(int_vec, 29) == 0, vec_free(int_vec));
+    vec_free(int_vec);
+    TEST_PASS();
+}
+
+#define INT_LESS(a, b) ((a) < (b))
+VEC_HEAP_DEFINE(int_heap, int, INT_LESS)
+
+TEST_MAKE(Heap_Vec)
+{
+    Vec *heap = vec_new(VECTOR_DEFAULT_CAP, sizeof(int), vec_int_cmp, NULL, NULL);
+    Vec *heap4 = vec_new(VECTOR_DEFAULT_CAP, sizeof(int), vec_int_cmp, NULL, NULL);
+    Vec *inl = VEC(int);
+    int value, i, out;
+    for (i = 0; i < 50; i++)
+    {
+        value = (i * 37) % 50;
+        vec_heap_push(heap, &value);
+        vec_heap4_push(heap4, &value);
+        int_heap_push(inl, &value);
+    }
+    TEST_ASSERT_CLEAN(*(int *)vec_heap_top(heap) == 49, TEST_BLOCK(vec_free(heap); vec_free(heap4); vec_free(inl)));
+    value = -1;
+    vec_heap_replace(heap, &value);
+    vec_heap4_replace(heap4, &value);
+    int_heap_replace(inl, &value);
+    for (i = 48; i >= 0; i--)
+    {
+        TEST_ASSERT_CLEAN(*(int *)vec_heap_pop(heap) == i, TEST_BLOCK(vec_free(heap); vec_free(heap4); vec_free(inl)));
+        TEST_ASSERT_CLEAN(*(int *)vec_heap4_pop(heap4) == i, TEST_BLOCK(vec_free(heap); vec_free(heap4); vec_free(inl)));
+        TEST_ASSERT_CLEAN(int_heap_pop(inl, &out) && out == i, TEST_BLOCK(vec_free(heap); vec_free(heap4); vec_free(inl)));
+    }
+    TEST_ASSERT_CLEAN(heap->len == 1 && *(int *)vec_heap_top(heap) == -1, TEST_BLOCK(vec_free(heap); vec_free(heap4); vec_free(inl)));
+    vec_free(heap);
+    vec_free(heap4);
+    vec_free(inl);
+    TEST_PASS();
+}
+
+TEST_MAKE(Select_Vec)
+{
+    Vec *int_vec = vec_new(VECTOR_DEFAULT_CAP, sizeof(int), vec_int_cmp, NULL, NULL);
+    Vec *top = VEC(int);
+    int value, i;
+    for (i = 0; i < 1000; i++)
+    {
+        value = (i * 7919) % 1000;
+        V_ADD(int_vec, &value);
+    }
+    vec_nth_element(int_vec, 500);
+    TEST_ASSERT_CLEAN(*(int *)vec_at(int_vec, 500) == 500, TEST_BLOCK(vec_free(int_vec); vec_free(top)));
+    for (i = 0; i < 1000; i++)
+    {
+        TEST_ASSERT_CLEAN((i < 500) == (*(int *)vec_at(int_vec, i) < 500), TEST_BLOCK(vec_free(int_vec); vec_free(top)));
+    }
+    TEST_ASSERT_CLEAN(vec_top_k(int_vec, 10, top) == 0 && top->len == 10, TEST_BLOCK(vec_free(int_vec); vec_free(top)));
+    vec_partial_sort(int_vec, 10);
+    for (i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_CLEAN(*(int *)vec_at(int_vec, i) == i, TEST_BLOCK(vec_free(int_vec); vec_free(top)));
+        TEST_ASSERT_CLEAN(*(int *)vec_at(top, i) == 999 - i, TEST_BLOCK(vec_free(int_vec); vec_free(top)));
+    }
+    vec_free(int_vec);
+    vec_free(top);
+    TEST_PASS();
+}
+
+TEST_MAKE(Set_Vec)
+{
+    Vec *a = vec_new(VECTOR_DEFAULT_CAP, sizeof(int), vec_int_cmp, NULL, NULL);
+    Vec *b = vec_new(VECTOR_DEFAULT_CAP, sizeof(int), vec_int_cmp, NULL, NULL);
+    Vec *out = VEC(int);
+    int value, i;
+    for (i = 0; i < 100; i++)
+    {
+        value = i / 2 * 2; /* 0 0 2 2 4 4 ... */
+        V_ADD(a, &value);
+        value = i * 3;
+        V_ADD(b, &value);
+    }
+    TEST_ASSERT_CLEAN(vec_unique(a) == 50 && a->len == 50, TEST_BLOCK(vec_free(a); vec_free(b); vec_free(out)));
+    vec_set_intersection(out, a, b); /* multiples of 6 below 100 */
+    TEST_ASSERT_CLEAN(out->len == 17 && *(int *)vec_at(out, 16) == 96, TEST_BLOCK(vec_free(a); vec_free(b); vec_free(out)));
+    vec_set_union(out, a, b);
+    TEST_ASSERT_CLEAN(out->len == 50 + 100 - 17, TEST_BLOCK(vec_free(a); vec_free(b); vec_free(out)));
+    vec_set_difference(out, a, b);
+    TEST_ASSERT_CLEAN(out->len == 50 - 17 && *(int *)vec_at(out, 0) == 2, TEST_BLOCK(vec_free(a); vec_free(b); vec_free(out)));
+    vec_free(a);
+    vec_free(b);
+    vec_free(out);
+    TEST_PASS();
+}
+
+static int test_data_name_cmp(const void *a, const void *b)
+{
+    return vec_char_cmp(((const struct test_data *)a)->name + 5, ((const struct test_data *)b)->name + 5);
+}
+
+TEST_MAKE(Stable_Sort_Vec)
+{
+    Vec *td_vec = vec_new(VECTOR_DEFAULT_CAP, sizeof(struct test_data), test_data_name_cmp, NULL, NULL);
+    int i;
+    for (i = 0; i < 300; i++)
+    {
+        struct test_data td = new_data(i);
+        V_ADD(td_vec, &td);
+    }
+    /* sorts by the first digit only, ties must keep their index order */
+    vec_stable_sort(td_vec);
+    TEST_ASSERT_CLEAN(td_vec->scratch != NULL, vec_free(td_vec));
+    for (i = 1; i < 300; i++)
+    {
+        struct test_data *prev = vec_at(td_vec, i - 1), *cur = vec_at(td_vec, i);
+        TEST_ASSERT_CLEAN(prev->name[5] <= cur->name[5], vec_free(td_vec));
+        if (prev->name[5] == cur->name[5])
+            TEST_ASSERT_CLEAN(prev->index < cur->index, vec_free(td_vec));
+    }
+    vec_free(td_vec);
+    TEST_PASS();
+}
+
+TEST_MAKE(Aligned_Vec)
+{
+    Vec *td_vec = VEC_ALIGNED(struct test_data);
+    int i;
+    for (i = 0; i < 200; i++)
+    {
+        struct test_data td = new_data(i);
+        V_ADD(td_vec, &td);
+        TEST_ASSERT_CLEAN((uintptr_t)td_vec->data % VEC_CACHE_LINE == 0, vec_free(td_vec));
+    }
+    vec_clamp(td_vec);
+    TEST_ASSERT_CLEAN((uintptr_t)td_vec->data % VEC_CACHE_LINE == 0, vec_free(td_vec));
+    TEST_ASSERT_CLEAN(((struct test_data *)vec_at(td_vec, 199))->index == 199, vec_free(td_vec));
+    vec_free(td_vec);
+    TEST_PASS();
+}
+
+TEST_MAKE(Emplace_Vec)
+{
+    Vec *td_vec = VEC(struct test_data);
+    td_vec->flags |= VEC_FLAG_NO_ZERO;
+    int i;
+    for (i = 0; i < 50; i++)
+    {
+        struct test_data *td = vec_emplace_back(td_vec);
+        td->index = i;
+        snprintf(td->name, 100, "index%d", i);
+    }
+    TEST_ASSERT_CLEAN(td_vec->len == 50, vec_free(td_vec));
+    TEST_ASSERT_CLEAN(strcmp(((struct test_data *)vec_at(td_vec, 49))->name, "index49") == 0, vec_free(td_vec));
+    vec_clear(td_vec);
+    TEST_ASSERT_CLEAN(td_vec->len == 0, vec_free(td_vec));
+    vec_resize_uninit(td_vec, 500);
+    TEST_ASSERT_CLEAN(td_vec->capacity == 500, vec_free(td_vec));
+    vec_free(td_vec);
+    TEST_PASS();
+}
+
+TEST_MAKE(Shrink_Vec)
+{
+    Vec *int_vec = VEC(int);
+    int_vec->shrink = vec_shrink_hysteresis;
+    int value, i;
+    for (i = 0; i < 1000; i++)
+    {
+        value = i;
+        V_ADD(int_vec, &value);
+    }
+    size_t peak = int_vec->capacity;
+    for (i = 999; i >= 10; i--)
+    {
+        TEST_ASSERT_CLEAN(*(int *)V_POP(int_vec) == i, vec_free(int_vec));
+    }
+    TEST_ASSERT_CLEAN(int_vec->capacity < peak / 8, vec_free(int_vec));
+    /* alternating push and pop at the boundary does not resize */
+    size_t cap = int_vec->capacity;
+    for (i = 0; i < 100; i++)
+    {
+        V_ADD(int_vec, &value);
+        V_POP(int_vec);
+    }
+    TEST_ASSERT_CLEAN(int_vec->capacity == cap, vec_free(int_vec));
+    vec_free(int_vec);
+    TEST_PASS();
+}
+
+TEST_MAKE(Zero_Cap_Vec)
+{
+    Vec *empty = vec_new(0, sizeof(int), NULL, NULL, NULL);
+    vec_free(empty);
+    Vec *int_vec = vec_new(0, sizeof(int), vec_int_cmp, NULL, NULL);
+    int i;
+    for (i = 0; i < 25; i++)
+        V_ADD(int_vec, &i);
+    TEST_ASSERT_CLEAN(int_vec->len == 25 && int_vec->capacity >= 25, vec_free(int_vec));
+    for (i = 0; i < 25; i++)
+        TEST_ASSERT_CLEAN(*(int *)vec_at(int_vec, i) == i, vec_free(int_vec));
+    vec_free(int_vec);
+    TEST_PASS();
+}
+
+TEST_MAKE(Rotate_Vec)
+{
+    /* every kernel width plus an odd one, with lengths that leave a middle for the scalar tail */
+    size_t sizes[] = {1, 2, 4, 8, 16, 24};
+    size_t s, n, i, j;
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        for (n = 0; n < 70; n += 3)
+        {
+            Vec *v = vec_new(n + 1, sizes[s], NULL, NULL, NULL);
+            byte elem[24];
+            for (i = 0; i < n; i++)
+            {
+                for (j = 0; j < sizes[s]; j++)
+                    elem[j] = (byte)(i * 31 + j);
+                V_ADD(v, elem);
+            }
+            V_REV(v);
+            for (i = 0; i < n; i++)
+                TEST_ASSERT_CLEAN(((byte *)vec_at(v, i))[sizes[s] - 1] == (byte)((n - 1 - i) * 31 + sizes[s] - 1), vec_free(v));
+            V_REV(v);
+            vec_rotate(v, n / 3 + 1);
+            for (i = 0; i < n; i++)
+                TEST_ASSERT_CLEAN(((byte *)vec_at(v, i))[0] == (byte)(((i + n / 3 + 1) % n) * 31), vec_free(v));
+            vec_free(v);
+        }
+    }
+    TEST_PASS();
+}
+
+TEST_MAKE(SoA_Vec)
+{
+    size_t sizes[] = {sizeof(int), sizeof(struct test_data)};
+    void_cmp_func cmps[] = {vec_int_cmp, NULL};
+    VecSoA *soa = vec_soa_new(4, 2, sizes, cmps);
+    int key, i;
+    struct test_data td;
+    const void *fields[] = {&key, &td};
+    for (i = 0; i < 40; i++)
+    {
+        key = (i * 7) % 10;
+        td = new_data(i);
+        vec_soa_push_back(soa, fields);
+    }
+    vec_soa_remove(soa, 0);
+    TEST_ASSERT_CLEAN(soa->len == 39 && vec_soa_column(soa, 1)->len == 39, vec_soa_free(soa));
+    TEST_ASSERT_CLEAN(((struct test_data *)vec_soa_at(soa, 1, 0))->index == 1, vec_soa_free(soa));
+    /* a missing field is rejected without touching any column */
+    const void *partial[] = {&key, NULL};
+    TEST_ASSERT_CLEAN(vec_soa_push_back(soa, partial) == 1 && vec_soa_insert(soa, 0, partial) == 1, vec_soa_free(soa));
+    TEST_ASSERT_CLEAN(vec_soa_insert(soa, 40, fields) == 1, vec_soa_free(soa));
+    TEST_ASSERT_CLEAN(soa->len == 39 && vec_soa_column(soa, 0)->len == 39 && vec_soa_column(soa, 1)->len == 39, vec_soa_free(soa));
+    TEST_ASSERT_CLEAN(vec_soa_swap(soa, 0, 39) == 1 && vec_soa_swap(soa, 39, 0) == 1, vec_soa_free(soa));
+    TEST_ASSERT_CLEAN(vec_soa_swap(soa, 0, 1) == 0 && ((struct test_data *)vec_soa_at(soa, 1, 0))->index == 2, vec_soa_free(soa));
+    vec_soa_swap(soa, 0, 1);
+    TEST_ASSERT_CLEAN(vec_soa_sort_by(soa, 2) == 1, vec_soa_free(soa));
+    TEST_ASSERT_CLEAN(vec_soa_sort_by(soa, 0) == 0, vec_soa_free(soa));
+    for (i = 1; i < 39; i++)
+    {
+        int k0 = *(int *)vec_soa_at(soa, 0, i - 1), k1 = *(int *)vec_soa_at(soa, 0, i);
+        struct test_data *d0 = vec_soa_at(soa, 1, i - 1), *d1 = vec_soa_at(soa, 1, i);
+        TEST_ASSERT_CLEAN(k0 < k1 || (k0 == k1 && d0->index < d1->index), vec_soa_free(soa));
+        TEST_ASSERT_CLEAN((int)(d1->index * 7 % 10) == k1, vec_soa_free(soa));
+    }
+    struct test_data *last = vec_soa_at(soa, 1, 38);
+    size_t last_index = last->index;
+    vec_soa_remove_fast(soa, 0);
+    TEST_ASSERT_CLEAN(((struct test_data *)vec_soa_at(soa, 1, 0))->index == last_index, vec_soa_free(soa));
+    key = 3;
+    size_t idx = vec_find_idx(vec_soa_column(soa, 0), &key);
+    TEST_ASSERT_CLEAN(idx != INVALID_FE_IDX && *(int *)vec_soa_at(soa, 0, idx) == 3, vec_soa_free(soa));
+    vec_soa_free(soa);
+    TEST_PASS();
+}
+
+TEST_MAKE(Bit_Vec)
+{
+    BitVec *a = bitvec_new(0), *b = bitvec_new(0);
+    size_t i;
+    for (i = 0; i < 200; i++)
+    {
+        bitvec_push(a, i % 3 == 0);
+        bitvec_push(b, i % 2 == 0);
+    }
+    TEST_ASSERT_CLEAN(bitvec_count(a) == 67, TEST_BLOCK(bitvec_free(a); bitvec_free(b)));
+    /* shifts every later bit across the word boundaries */
+    bitvec_insert(a, 5, 1);
+    TEST_ASSERT_CLEAN(bitvec_get(a, 5) && bitvec_get(a, 7) && !bitvec_get(a, 6) && bitvec_get(a, 199), TEST_BLOCK(bitvec_free(a); bitvec_free(b)));
+    bitvec_remove(a, 5);
+    bitvec_remove(a, 200);
+    TEST_ASSERT_CLEAN(a->len == 200 && bitvec_count(a) == 67, TEST_BLOCK(bitvec_free(a); bitvec_free(b)));
+    TEST_ASSERT_CLEAN(bitvec_find_first_set(a) == 0 && bitvec_find_next_set(a, 0) == 3, TEST_BLOCK(bitvec_free(a); bitvec_free(b)));
+    TEST_ASSERT_CLEAN(bitvec_find_next_set(a, 198) == BITVEC_NONE, TEST_BLOCK(bitvec_free(a); bitvec_free(b)));
+    bitvec_and(a, a, b);
+    TEST_ASSERT_CLEAN(bitvec_count(a) == 34, TEST_BLOCK(bitvec_free(a); bitvec_free(b)));
+    bitvec_andnot(b, b, a);
+    TEST_ASSERT_CLEAN(bitvec_count(b) == 66 && !bitvec_get(b, 0) && bitvec_get(b, 2), TEST_BLOCK(bitvec_free(a); bitvec_free(b)));
+    bitvec_push(b, 1);
+    TEST_ASSERT_CLEAN(bitvec_or(a, a, b) == 1, TEST_BLOCK(bitvec_free(a); bitvec_free(b)));
+    bitvec_free(a);
+    bitvec_free(b);
+    TEST_PASS();
+}
+
+TEST_MAKE(Pool_Str_Vec)
+{
+    StrVec *sv = strvec_new(4, 16);
+    char buf[100];
+    int i;
+    for (i = 100; i >= 0; i--)
+    {
+        snprintf(buf, 100, "index%d", i);
+        strvec_push(sv, buf);
+    }
+    /* pushing an entry of the same vector while the blob grows */
+    strvec_push(sv, strvec_at(sv, 0));
+    TEST_ASSERT_CLEAN(strvec_size(sv) == 102 && strcmp(strvec_at(sv, 101), "index100") == 0, strvec_free(sv));
+    /* NULL bytes with a length are refused before anything is pushed */
+    strvec_push_n(sv, NULL, 5);
+    strvec_push(sv, NULL);
+    TEST_ASSERT_CLEAN(strvec_size(sv) == 102, strvec_free(sv));
+    TEST_ASSERT_CLEAN(strvec_find(sv, "index42") == 58 && strvec_find(sv, "index") == INVALID_FE_IDX, strvec_free(sv));
+    strvec_sort(sv);
+    TEST_ASSERT_CLEAN(strcmp(strvec_at(sv, 0), "index0") == 0 && strcmp(strvec_at(sv, 1), "index1") == 0, strvec_free(sv));
+    for (i = 1; i < 102; i++)
+    {
+        TEST_ASSERT_CLEAN(strcmp(strvec_at(sv, i - 1), strvec_at(sv, i)) <= 0, strvec_free(sv));
+        /* equal strings keep the order they were pushed in */
+        if (strcmp(strvec_at(sv, i - 1), strvec_at(sv, i)) == 0)
+            TEST_ASSERT_CLEAN(strvec_at(sv, i - 1) < strvec_at(sv, i), strvec_free(sv));
+    }
+    TEST_ASSERT_CLEAN(strvec_len_at(sv, 101) == 7, strvec_free(sv));
+    strvec_clear(sv);
+    TEST_ASSERT_CLEAN(strvec_size(sv) == 0 && strvec_at(sv, 0) == NULL, strvec_free(sv));
+    strvec_free(sv);
+    TEST_PASS();
+}
+
+static int is_odd_ptr(const void *elem, void *ctx)
+{
+    (void)ctx;
+    return **(int *const *)elem % 2;
+}
+
+static size_t freed_runs, freed_entries;
+
+static void count_free_range(void *first, size_t count, size_t elem_size)
+{
+    freed_runs++;
+    freed_entries += count;
+    vec_deref_free_range(first, count, elem_size);
+}
+
+TEST_MAKE(Free_Range_Vec)
+{
+    Vec *ptr_vec = VEC(int *);
+    ptr_vec->free_range = count_free_range;
+    int i;
+    for (i = 0; i < 100; i++)
+    {
+        int *p = malloc(sizeof(int));
+        *p = i / 10;
+        V_ADD(ptr_vec, &p);
+    }
+    freed_runs = freed_entries = 0;
+    /* values are i / 10, so the odd ones come in 5 runs of 10 */
+    TEST_ASSERT_CLEAN(vec_remove_if(ptr_vec, is_odd_ptr, NULL) == 50 && freed_runs == 5 && freed_entries == 50, vec_free(ptr_vec));
+    vec_resize(ptr_vec, 30);
+    TEST_ASSERT_CLEAN(ptr_vec->len == 30 && freed_runs == 6 && freed_entries == 70, vec_free(ptr_vec));
+    vec_clear(ptr_vec);
+    TEST_ASSERT_CLEAN(freed_runs == 7 && freed_entries == 100, vec_free(ptr_vec));
+    vec_free(ptr_vec);
+    TEST_PASS();
+}
+
+TEST_MAKE(Slot_Map_Vec)
+{
+    SlotMap *sm = slotmap_new(4, sizeof(int));
+    SlotHandle handles[20];
+    int i;
+    for (i = 0; i < 20; i++)
+        handles[i] = slotmap_insert(sm, &i);
+    /* removing from the front moves the last elements, the other handles still find their values */
+    for (i = 0; i < 10; i++)
+        TEST_ASSERT_CLEAN(slotmap_remove(sm, handles[i]) == 0, slotmap_free(sm));
+    TEST_ASSERT_CLEAN(slotmap_size(sm) == 10 && slotmap_remove(sm, handles[3]) == 1, slotmap_free(sm));
+    for (i = 0; i < 20; i++)
+    {
+        int *p = slotmap_get(sm, handles[i]);
+        TEST_ASSERT_CLEAN(i < 10 ? p == NULL : (p && *p == i), slotmap_free(sm));
+    }
+    /* a reused slot gets a new generation */
+    int value = 100;
+    SlotHandle h = slotmap_insert(sm, &value);
+    TEST_ASSERT_CLEAN((uint32_t)h == (uint32_t)handles[9] && h != handles[9], slotmap_free(sm));
+    TEST_ASSERT_CLEAN(!slotmap_contains(sm, handles[9]) && *(int *)slotmap_get(sm, h) == 100, slotmap_free(sm));
+    TEST_ASSERT_CLEAN(slotmap_get(sm, SLOTMAP_INVALID) == NULL, slotmap_free(sm));
+    int sum = 0;
+    V_FOR_EACH_FAST(slotmap_dense(sm), int, elem)
+    {
+        sum += *elem;
+    }
+    TEST_ASSERT_CLEAN(sum == 245, slotmap_free(sm));
+    slotmap_clear(sm);
+    TEST_ASSERT_CLEAN(slotmap_size(sm) == 0 && !slotmap_contains(sm, h), slotmap_free(sm));
+    slotmap_free(sm);
+    TEST_PASS();
+}
+
+TEST_MAKE(Compressed_Vec)
+{
+    Vec *ids = vec_new(1000, sizeof(unsigned long long), vec_ull_cmp, NULL, NULL);
+    unsigned long long id = 1ull << 40;
+    size_t i;
+    for (i = 0; i < 1000; i++)
+    {
+        id += 1 + i % 7;
+        V_ADD(ids, &id);
+    }
+    CompVec *cv = compvec_from_vec(ids);
+    TEST_ASSERT_CLEAN(cv && cv->len == 1000, vec_free(ids));
+    /* small gaps pack into a few bits per value */
+    TEST_ASSERT_CLEAN(compvec_bytes(cv) < 1000 * sizeof(uint64_t) / 2, TEST_BLOCK(vec_free(ids); compvec_free(cv)));
+    for (i = 0; i < 1000; i += 37)
+        TEST_ASSERT_CLEAN(compvec_at(cv, i) == *(unsigned long long *)vec_at(ids, i), TEST_BLOCK(vec_free(ids); compvec_free(cv)));
+    unsigned long long key = *(unsigned long long *)vec_at(ids, 500) - 1;
+    TEST_ASSERT_CLEAN(compvec_lower_bound(cv, key) == 500 && compvec_lower_bound(cv, id + 1) == 1000, TEST_BLOCK(vec_free(ids); compvec_free(cv)));
+    TEST_ASSERT_CLEAN(compvec_push(cv, id - 1) == 1 && compvec_push(cv, id) == 0, TEST_BLOCK(vec_free(ids); compvec_free(cv)));
+    Vec *back = compvec_to_vec(cv);
+    TEST_ASSERT_CLEAN(back->len == 1001 && memcmp(back->data, ids->data, 1000 * sizeof(uint64_t)) == 0,
+                      TEST_BLOCK(vec_free(ids); vec_free(back); compvec_free(cv)));
+    CompVecIter it = compvec_iter(cv);
+    uint64_t value;
+    for (i = 0; compvec_iter_next(&it, &value); i++)
+        TEST_ASSERT_CLEAN(i < back->len && value == ((uint64_t *)back->data)[i], TEST_BLOCK(vec_free(ids); vec_free(back); compvec_free(cv)));
+    TEST_ASSERT_CLEAN(i == 1001 && !compvec_iter_next(&it, &value), TEST_BLOCK(vec_free(ids); vec_free(back); compvec_free(cv)));
+    vec_free(back);
+    vec_free(ids);
+    compvec_free(cv);
+    TEST_PASS();
+}
+
+/* checks every value of cv against expect through compvec_at, compvec_iter and compvec_to_vec */
+static int compvec_matches(CompVec *cv, const uint64_t *expect, size_t n)
+{
+    CompVecIter it = compvec_iter(cv);
+    uint64_t value;
+    size_t i;
+    int ok = cv->len == n;
+    for (i = 0; ok && i < n; i++)
+        ok = compvec_at(cv, i) == expect[i] && compvec_iter_next(&it, &value) && value == expect[i];
+    Vec *back = compvec_to_vec(cv);
+    ok = ok && !compvec_iter_next(&it, &value) && back->len == n && memcmp(back->data, expect, n * sizeof(uint64_t)) == 0;
+    vec_free(back);
+    return ok;
+}
+
+TEST_MAKE(Compressed_Width_Vec)
+{
+    /* widths from 0 to 64 bits, values of 1, 5 and 13 bits never start at a word boundary */
+    unsigned widths[] = {0, 1, 5, 13, 31, 32, 33, 47, 55};
+    uint64_t values[3 * COMPVEC_BLOCK + 10];
+    size_t n = sizeof(values) / sizeof(values[0]), w, i;
+    for (w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+    {
+        unsigned bits = widths[w];
+        uint64_t mask = bits ? ((uint64_t)1 << bits) - 1 : 0;
+        values[0] = 1000;
+        for (i = 1; i < n; i++)
+        {
+            /* every block sees a gap of exactly base and one of base + mask, so it packs at bits */
+            uint64_t spread = i % COMPVEC_BLOCK == 1 ? 0 : i % COMPVEC_BLOCK == 2 ? mask : (i * 0x9E3779B97F4A7C15ull) & mask;
+            values[i] = values[i - 1] + 3 + spread;
+        }
+        CompVec *cv = compvec_new();
+        for (i = 0; i < n; i++)
+            compvec_push(cv, values[i]);
+        TEST_ASSERT_CLEAN(cv->blocks->len == 3, compvec_free(cv));
+        for (i = 0; i < 3; i++)
+            TEST_ASSERT_CLEAN(((CompVecBlock *)vec_at(cv->blocks, i))->bits == bits && ((CompVecBlock *)vec_at(cv->blocks, i))->base == 3, compvec_free(cv));
+        TEST_ASSERT_CLEAN(compvec_matches(cv, values, n), compvec_free(cv));
+        TEST_ASSERT_CLEAN(compvec_lower_bound(cv, values[200]) == 200 && compvec_lower_bound(cv, values[200] + 1) == 201, compvec_free(cv));
+        compvec_free(cv);
+    }
+
+    /* a gap near 2^64 needs the full 64 bits, the rest of the block steps by 1 */
+    values[0] = 0;
+    values[1] = 0;
+    for (i = 2; i < COMPVEC_BLOCK + 5; i++)
+        values[i] = UINT64_MAX - 1000 + i;
+    CompVec *cv = compvec_new();
+    for (i = 0; i < COMPVEC_BLOCK + 5; i++)
+        TEST_ASSERT_CLEAN(compvec_push(cv, values[i]) == 0, compvec_free(cv));
+    TEST_ASSERT_CLEAN(cv->blocks->len == 1 && ((CompVecBlock *)vec_at(cv->blocks, 0))->bits == 64, compvec_free(cv));
+    TEST_ASSERT_CLEAN(compvec_matches(cv, values, COMPVEC_BLOCK + 5), compvec_free(cv));
+    TEST_ASSERT_CLEAN(compvec_lower_bound(cv, 1) == 2 && compvec_lower_bound(cv, UINT64_MAX) == COMPVEC_BLOCK + 5, compvec_free(cv));
+    compvec_free(cv);
+    TEST_PASS();
+}
+
+TEST_MAKE(Search_Index_Vec)
+{
+    Vec *v = vec_new(1000, sizeof(int), vec_int_cmp, NULL, NULL);
+    int x, keys[64];
+    size_t i, out[64];
+    for (x = 0; x < 3000; x += 3)
+        V_ADD(v, &x);
+    VecSearchIndex *idx = vec_build_search_index(v);
+    TEST_ASSERT_CLEAN(idx && idx->len == 1000, vec_free(v));
+    for (i = 0; i < 64; i++)
+        keys[i] = (int)(i * 49) - 5;
+    vec_search_index_lower_bound_batch(idx, keys, 64, out);
+    for (i = 0; i < 64; i++)
+    {
+        /* first multiple of 3 not less than the key */
+        size_t expect = keys[i] <= 0 ? 0 : (size_t)(keys[i] + 2) / 3;
+        if (expect > 1000)
+            expect = 1000;
+        TEST_ASSERT_CLEAN(out[i] == expect && vec_search_index_lower_bound(idx, &keys[i]) == expect,
+                          TEST_BLOCK(vec_free(v); vec_search_index_free(idx)));
+        TEST_ASSERT_CLEAN(vec_search_index_contains(idx, &keys[i]) == (keys[i] >= 0 && keys[i] < 3000 && keys[i] % 3 == 0),
+                          TEST_BLOCK(vec_free(v); vec_search_index_free(idx)));
+    }
+    vec_search_index_free(idx);
+    /* unsorted input is refused */
+    vec_swap(v, 0, 1);
+    TEST_ASSERT_CLEAN(vec_build_search_index(v) == NULL, vec_free(v));
+    vec_free(v);
+    TEST_PASS();
+}
+
+/* element types of the numeric kernels, values are handled sign or zero extended to 64 bits */
+struct numeric_type
+{
+    size_t elem_size;
+    int is_signed;
+    void_cmp_func cmp;
+};
+
+static uint64_t numeric_load(const struct numeric_type *t, const void *p)
+{
+    if (t->elem_size == 8)
+    {
+        uint64_t x;
+        memcpy(&x, p, 8);
+        return x;
+    }
+    uint32_t x;
+    memcpy(&x, p, 4);
+    return t->is_signed ? (uint64_t)(int64_t)(int32_t)x : x;
+}
+
+static void numeric_store(const struct numeric_type *t, void *p, uint64_t x)
+{
+    uint32_t lo = (uint32_t)x;
+    if (t->elem_size == 8)
+        memcpy(p, &x, 8);
+    else
+        memcpy(p, &lo, 4);
+}
+
+static int numeric_less(const struct numeric_type *t, uint64_t a, uint64_t b)
+{
+    return t->is_signed ? (int64_t)a < (int64_t)b : a < b;
+}
+
+/* runs every kernel over n pseudo random values of type t and compares with a plain loop */
+static int numeric_check(const struct numeric_type *t, size_t n)
+{
+    Vec *v = vec_new(n, t->elem_size, t->cmp, NULL, NULL);
+    unsigned bits = (unsigned)t->elem_size * 8;
+    uint64_t state = 0x243F6A8885A308D3ull ^ n, sum = 0, lo, width, x;
+    uint64_t min = 0, max = 0, got_min = 0, got_max = 0;
+    size_t i, argmin = 0, counts[6], expect[6];
+    int64_t got_sum;
+    int ok = 1;
+    for (i = 0; i < n; i++)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        x = state ^ (state >> 29);
+        numeric_store(t, vec_emplace_back(v), x);
+    }
+    /* the extremes of the type, twice for the smallest so argmin has to find the first */
+    numeric_store(t, vec_at(v, n / 3), t->is_signed ? (uint64_t)1 << (bits - 1) : 0);
+    numeric_store(t, vec_at(v, n - 1), t->is_signed ? (uint64_t)1 << (bits - 1) : 0);
+    numeric_store(t, vec_at(v, n / 2), t->is_signed ? ((uint64_t)1 << (bits - 1)) - 1 : ~(uint64_t)0);
+    for (i = 0; i < n; i++)
+    {
+        x = numeric_load(t, vec_at(v, i));
+        sum += x;
+        if (!i || numeric_less(t, x, min))
+        {
+            min = x;
+            argmin = i;
+        }
+        if (!i || numeric_less(t, max, x))
+            max = x;
+    }
+    ok = ok && vec_sum_i64(v, &got_sum) == 0 && (uint64_t)got_sum == sum;
+    ok = ok && vec_minmax(v, &got_min, &got_max) == 0 && numeric_load(t, &got_min) == min && numeric_load(t, &got_max) == max;
+    ok = ok && vec_argmin(v) == argmin && argmin == n / 3;
+
+    /* six bins around the middle of the range, a power of two width and one that needs a division */
+    for (width = (uint64_t)1 << (bits - 4); ok && width <= ((uint64_t)1 << (bits - 4)) + 3; width += 3)
+    {
+        byte lo_bytes[8];
+        lo = t->is_signed ? ~(((uint64_t)1 << (bits - 2)) - 1) : (uint64_t)1 << (bits - 2);
+        numeric_store(t, lo_bytes, lo);
+        memset(expect, 0, sizeof(expect));
+        for (i = 0; i < n; i++)
+        {
+            x = numeric_load(t, vec_at(v, i));
+            if (!numeric_less(t, x, lo) && (x - lo) / width < 6)
+                expect[(x - lo) / width]++;
+        }
+        ok = ok && vec_histogram(v, lo_bytes, width, counts, 6) == 0 && memcmp(counts, expect, sizeof(counts)) == 0;
+    }
+
+    /* the sums wrap in the element type */
+    Vec *copy = vec_copy(v);
+    ok = ok && vec_prefix_sum(v) == 0;
+    for (i = 0, sum = 0; ok && i < n; i++)
+    {
+        byte elem[8];
+        sum += numeric_load(t, vec_at(copy, i));
+        numeric_store(t, elem, sum);
+        ok = memcmp(vec_at(v, i), elem, t->elem_size) == 0;
+    }
+    vec_free(copy);
+    vec_free(v);
+    return ok;
+}
+
+TEST_MAKE(Numeric_Vec)
+{
+    struct numeric_type types[] = {{sizeof(int), 1, vec_int_cmp},
+                                   {sizeof(unsigned int), 0, vec_uint_cmp},
+                                   {sizeof(long long), 1, vec_ll_cmp},
+                                   {sizeof(unsigned long long), 0, vec_ull_cmp}};
+    size_t t;
+    for (t = 0; t < 4; t++)
+    {
+        TEST_ASSERT_CLEAN_LOG(numeric_check(&types[t], 100), (void)0, "type %zu", t);
+        TEST_ASSERT_CLEAN_LOG(numeric_check(&types[t], 1003), (void)0, "type %zu", t);
+        /* large enough to be split across threads */
+        TEST_ASSERT_CLEAN_LOG(numeric_check(&types[t], VEC_NUMERIC_THREAD_BYTES / types[t].elem_size + 77), (void)0, "type %zu", t);
+    }
+
+    Vec *v = vec_new(100, sizeof(int), vec_int_cmp, NULL, NULL);
+    int x, min, max, lo = -10;
+    int64_t sum;
+    size_t i, counts[4];
+    for (i = 0; i < 100; i++)
+    {
+        x = (int)(i * 37 % 101) - 50;
+        V_ADD(v, &x);
+    }
+    TEST_ASSERT_CLEAN(vec_sum_i64(v, &sum) == 0 && sum == 100 * 101 / 2 - 5000 - 64, vec_free(v));
+    TEST_ASSERT_CLEAN(vec_minmax(v, &min, &max) == 0 && min == -50 && max == 50, vec_free(v));
+    TEST_ASSERT_CLEAN(vec_argmin(v) == 0, vec_free(v));
+    /* -10 to 9 in bins of 5 */
+    TEST_ASSERT_CLEAN(vec_histogram(v, &lo, 5, counts, 4) == 0 && counts[0] == 5 && counts[3] == 5, vec_free(v));
+    TEST_ASSERT_CLEAN(vec_prefix_sum(v) == 0 && *(int *)vec_at(v, 1) == -50 - 13 && *(int *)vec_at(v, 99) == (int)sum, vec_free(v));
+    vec_free(v);
+    Vec *d = vec_new(10, sizeof(double), NULL, NULL, NULL);
+    TEST_ASSERT_CLEAN(vec_sum_i64(d, &sum) == 1 && vec_argmin(d) == INVALID_FE_IDX, vec_free(d));
+    vec_free(d);
+    TEST_PASS();
+}
+
+/* the last case is sized from VEC_COPY_THREAD_BYTES, build with a small -DVEC_COPY_THREAD_BYTES to split it between threads */
+TEST_MAKE(Copy_Vec)
+{
+    Vec *v = vec_new(100, sizeof(int), vec_int_cmp, NULL, NULL);
+    int i;
+    for (i = 0; i < 60; i++)
+        V_ADD(v, &i);
+    Vec *c = vec_copy(v);
+    TEST_ASSERT_CLEAN(c->len == 60 && c->capacity == 100 && memcmp(c->data, v->data, 60 * sizeof(int)) == 0,
+                      TEST_BLOCK(vec_free(v); vec_free(c)));
+    /* source has spare capacity, only its len elements are appended */
+    TEST_ASSERT_CLEAN(vec_append(c, v) == 0 && c->len == 120 && *(int *)vec_at(c, 119) == 59, TEST_BLOCK(vec_free(v); vec_free(c)));
+    TEST_ASSERT_CLEAN(vec_append(c, c) == 0 && c->len == 240 && *(int *)vec_at(c, 180) == 0, TEST_BLOCK(vec_free(v); vec_free(c)));
+    vec_free(c);
+    /* large enough for the streaming copy */
+    vec_resize(v, (VEC_STREAM_THRESHOLD / sizeof(int)) + 1000);
+    v->len = v->capacity;
+    for (i = 0; i < (int)v->len; i += 4099)
+        *(int *)vec_at(v, (size_t)i) = i;
+    size_t count;
+    int *arr = vec_arr_copy(v, &count);
+    TEST_ASSERT_CLEAN(count == v->len && memcmp(arr, v->data, count * sizeof(int)) == 0, TEST_BLOCK(vec_free(v); free(arr)));
+    free(arr);
+    vec_free(v);
+
+    /* large enough to be split between threads, 52 bytes past a multiple of 64 so the last part is short */
+    size_t n = VEC_COPY_THREAD_BYTES / sizeof(int) + 13, j;
+    v = vec_new(n, sizeof(int), vec_int_cmp, NULL, NULL);
+    for (j = 0; j < n; j++)
+        ((int *)v->data)[j] = (int)(j * 2654435761u);
+    v->len = n;
+    c = vec_copy(v);
+    TEST_ASSERT_CLEAN(c->len == n && memcmp(c->data, v->data, n * sizeof(int)) == 0, TEST_BLOCK(vec_free(v); vec_free(c)));
+    vec_free(c);
+    arr = vec_arr_copy(v, &count);
+    TEST_ASSERT_CLEAN(count == n && memcmp(arr, v->data, n * sizeof(int)) == 0, TEST_BLOCK(vec_free(v); free(arr)));
+    free(arr);
+    TEST_ASSERT_CLEAN(vec_append(v, v) == 0 && v->len == 2 * n, vec_free(v));
+    for (j = 0; j < 2 * n; j++)
+        TEST_ASSERT_CLEAN(((int *)v->data)[j] == (int)(j % n * 2654435761u), vec_free(v));
+    vec_free(v);
+    TEST_PASS();
+}
+
+/* sized from VEC_MMAP_THRESHOLD, build with a small -DVEC_MMAP_THRESHOLD (say 65536) to keep it cheap */
+TEST_MAKE(Mmap_Vec)
+{
+    size_t n = VEC_MMAP_THRESHOLD / sizeof(int) + 100, i;
+    Vec *v = vec_new(16, sizeof(int), NULL, NULL, NULL);
+    int value;
+    for (i = 0; i < n; i++)
+    {
+        value = (int)i;
+        V_ADD(v, &value);
+    }
+#if defined(__linux__) && !defined(VEC_DISABLE_MMAP)
+    TEST_ASSERT_CLEAN(v->flags & VEC_FLAG_MMAP, vec_free(v));
+#endif
+    for (i = 0; i < n; i += 997)
+        TEST_ASSERT_CLEAN(*(int *)vec_at(v, i) == (int)i, vec_free(v));
+
+    Vec *copy = vec_copy(v);
+    TEST_ASSERT_CLEAN(copy->len == n && (copy->flags & VEC_FLAG_MMAP) == (v->flags & VEC_FLAG_MMAP) &&
+                          memcmp(copy->data, v->data, n * sizeof(int)) == 0,
+                      TEST_BLOCK(vec_free(v); vec_free(copy)));
+    vec_free(copy);
+
+    /* shrinking below the threshold keeps the mapping and the surviving elements */
+    vec_resize(v, 100);
+    TEST_ASSERT_CLEAN(v->len == 100 && v->capacity == 100, vec_free(v));
+    for (i = 0; i < 100; i++)
+        TEST_ASSERT_CLEAN(*(int *)vec_at(v, i) == (int)i, vec_free(v));
+    /* and growing back across it */
+    for (i = 100; i < n; i++)
+    {
+        value = (int)i;
+        V_ADD(v, &value);
+    }
+    TEST_ASSERT_CLEAN(*(int *)vec_at(v, n - 1) == (int)(n - 1), vec_free(v));
+    vec_clear(v);
+    vec_clamp(v);
+    TEST_ASSERT_CLEAN(v->capacity == 0, vec_free(v));
+    vec_free(v);
+
+    /* an aligned vector crossing the threshold moves from posix_memalign to a mapping */
+    Vec *aligned = vec_new_aligned(16, sizeof(int), VEC_CACHE_LINE, NULL, NULL, NULL);
+    for (i = 0; i < n; i++)
+    {
+        value = (int)i;
+        V_ADD(aligned, &value);
+    }
+    TEST_ASSERT_CLEAN((uintptr_t)aligned->data % VEC_CACHE_LINE == 0 && *(int *)vec_at(aligned, n / 2) == (int)(n / 2),
+                      vec_free(aligned));
+    vec_free(aligned);
+    TEST_PASS();
+}
+
+#ifdef VEC_ENABLE_STATS
+static int stats_output_has(void (*dump)(FILE *, Vec *), Vec *v, const char *line)
+{
+    char buf[1024];
+    size_t n;
+    FILE *f = tmpfile();
+    if (!f)
+        return 0;
+    if (dump)
+        dump(f, v);
+    else
+        vec_stats_dump(f);
+    rewind(f);
+    n = fread(buf, 1, sizeof(buf) - 1, f);
+    buf[n] = 0;
+    fclose(f);
+    return strstr(buf, line) != NULL;
+}
+
+TEST_MAKE(Stats_Vec)
+{
+    vec_stats_reset();
+    Vec *v = vec_new(4, sizeof(int), vec_int_cmp, NULL, NULL);
+    Vec *top = vec_new(4, sizeof(int), vec_int_cmp, NULL, NULL);
+    Vec *copy;
+    size_t reallocs, copied, i;
+    int x;
+    TEST_ASSERT_CLEAN(v->stats.sorts == 0 && v->stats.find_cmps == 0 && v->stats.bytes_moved == 0, vec_free(v); vec_free(top));
+    reallocs = v->stats.reallocs;
+    for (i = 0; i < 100; i++)
+    {
+        x = (int)((i * 37) % 100);
+        V_ADD(v, &x);
+    }
+    TEST_ASSERT_CLEAN(v->stats.reallocs > reallocs, vec_free(v); vec_free(top));
+    TEST_ASSERT_CLEAN(v->stats.peak_capacity >= 100, vec_free(v); vec_free(top));
+
+    /* the tail after the insertion point is moved once each way */
+    x = -1;
+    vec_insert(v, 10, &x);
+    TEST_ASSERT_CLEAN(v->stats.bytes_moved == 90 * sizeof(int), vec_free(v); vec_free(top));
+    vec_remove(v, 10);
+    TEST_ASSERT_CLEAN(v->stats.bytes_moved == 180 * sizeof(int), vec_free(v); vec_free(top));
+
+    /* one comparison per element up to and including the match */
+    x = *(int *)vec_at(v, 9);
+    TEST_ASSERT_CLEAN(vec_find(v, &x) == vec_at(v, 9) && v->stats.find_cmps == 10, vec_free(v); vec_free(top));
+
+    copied = v->stats.bytes_copied;
+    copy = vec_copy(v);
+    TEST_ASSERT_CLEAN(copy && v->stats.bytes_copied - copied == v->len * v->elem_size, vec_free(v); vec_free(top); vec_free(copy));
+    vec_free(copy);
+
+    vec_nth_element(v, 50);
+    TEST_ASSERT_CLEAN(v->stats.sorts == 1, vec_free(v); vec_free(top));
+    vec_partial_sort(v, 10);
+    TEST_ASSERT_CLEAN(v->stats.sorts == 2, vec_free(v); vec_free(top));
+    TEST_ASSERT_CLEAN(vec_top_k(v, 5, top) == 0 && v->stats.sorts == 3 && top->stats.sorts == 0, vec_free(v); vec_free(top));
+    vec_stable_sort(v);
+    TEST_ASSERT_CLEAN(v->stats.sorts == 4, vec_free(v); vec_free(top));
+    vec_sort(v);
+    TEST_ASSERT_CLEAN(v->stats.sorts == 5, vec_free(v); vec_free(top));
+
+    /* the process wide counters saw every vector since the reset */
+    TEST_ASSERT_CLEAN(vec_stats_global()->sorts == 5 && vec_stats_global()->find_cmps == 10, vec_free(v); vec_free(top));
+    TEST_ASSERT_CLEAN(vec_stats_global()->reallocs >= v->stats.reallocs + top->stats.reallocs, vec_free(v); vec_free(top));
+    TEST_ASSERT_CLEAN(stats_output_has(NULL, NULL, "vec stats (all vectors):"), vec_free(v); vec_free(top));
+    TEST_ASSERT_CLEAN(stats_output_has(NULL, NULL, "\tsorts:         5\n"), vec_free(v); vec_free(top));
+    TEST_ASSERT_CLEAN(stats_output_has(vec_stats_dump_vec, v, "\tfind cmps:     10\n"), vec_free(v); vec_free(top));
+    TEST_ASSERT_CLEAN(stats_output_has(vec_stats_dump_vec, top, "\tsorts:         0\n"), vec_free(v); vec_free(top));
+    vec_stats_reset();
+    TEST_ASSERT_CLEAN(vec_stats_global()->sorts == 0 && v->stats.sorts == 5, vec_free(v); vec_free(top));
+    vec_free(v);
+    vec_free(top);
+    TEST_PASS();
+}
+#endif
+
+struct trace_seen
+{
+    size_t count;
+    VecEvent event;
+    size_t old_cap, new_cap, bytes;
+    size_t cap_in_hook; /* v->capacity when the hook ran */
+    const char *tag;
+};
+
+static struct trace_seen trace_local, trace_global;
+
+static void trace_record(struct trace_seen *seen, Vec *v, VecEvent event, size_t old_cap, size_t new_cap, size_t bytes, const char *tag)
+{
+    seen->count++;
+    seen->event = event;
+    seen->old_cap = old_cap;
+    seen->new_cap = new_cap;
+    seen->bytes = bytes;
+    seen->cap_in_hook = v->capacity;
+    seen->tag = tag;
+}
+
+static void trace_local_hook(Vec *v, VecEvent event, size_t old_cap, size_t new_cap, size_t bytes, const char *tag)
+{
+    trace_record(&trace_local, v, event, old_cap, new_cap, bytes, tag);
+}
+
+static void trace_global_hook(Vec *v, VecEvent event, size_t old_cap, size_t new_cap, size_t bytes, const char *tag)
+{
+    trace_record(&trace_global, v, event, old_cap, new_cap, bytes, tag);
+}
+
+static uint64_t trace_get_le(const byte *src, size_t len)
+{
+    uint64_t value = 0;
+    while (len--)
+        value = (value << 8) | src[len];
+    return value;
+}
+
+/* reads the next record the way trace report.c does, tag must hold 64 bytes */
+static int trace_read_record(FILE *f, byte record[32], char *tag)
+{
+    size_t tag_len;
+    if (fread(record, 1, 32, f) != 32)
+        return 0;
+    tag_len = (size_t)trace_get_le(record + 2, 2);
+    if (tag_len >= 64 || fread(tag, 1, tag_len, f) != tag_len)
+        return 0;
+    tag[tag_len] = '\0';
+    return 1;
+}
+
+TEST_MAKE(Trace_Vec)
+{
+    const char *path = "vec trace test.bin";
+    Vec *v = vec_new(4, sizeof(int), vec_int_cmp, NULL, NULL);
+    Vec *w;
+    int i;
+    memset(&trace_local, 0, sizeof(trace_local));
+    memset(&trace_global, 0, sizeof(trace_global));
+    v->trace = trace_local_hook;
+    v->trace_tag = "local";
+    vec_trace_set_global(trace_global_hook);
+
+    /* the per vector hook wins and sees the vector after the resize */
+    for (i = 0; i < 5; i++)
+        V_ADD(v, &i);
+    TEST_ASSERT_CLEAN(trace_local.count == 1 && trace_global.count == 0, vec_trace_set_global(NULL); vec_free(v));
+    TEST_ASSERT_CLEAN(trace_local.event == VEC_EVENT_GROW && trace_local.old_cap == 4 && trace_local.new_cap == 8, vec_trace_set_global(NULL); vec_free(v));
+    TEST_ASSERT_CLEAN(trace_local.cap_in_hook == 8 && trace_local.bytes == 8 * sizeof(int), vec_trace_set_global(NULL); vec_free(v));
+    TEST_ASSERT_CLEAN(strcmp(trace_local.tag, "local") == 0, vec_trace_set_global(NULL); vec_free(v));
+    vec_resize(v, 6);
+    TEST_ASSERT_CLEAN(trace_local.event == VEC_EVENT_SHRINK && trace_local.old_cap == 8 && trace_local.new_cap == 6 && trace_local.cap_in_hook == 6, vec_trace_set_global(NULL); vec_free(v));
+    vec_clamp(v);
+    TEST_ASSERT_CLEAN(trace_local.event == VEC_EVENT_SHRINK && trace_local.old_cap == 6 && trace_local.new_cap == 5 && trace_local.cap_in_hook == 5, vec_trace_set_global(NULL); vec_free(v));
+
+    /* memmoves are reported from the threshold up */
+    vec_resize(v, 16);
+    vec_trace_set_memmove_threshold(5 * sizeof(int));
+    trace_local.count = 0;
+    vec_insert(v, 1, &i);
+    TEST_ASSERT_CLEAN(trace_local.count == 0, vec_trace_set_memmove_threshold(VEC_TRACE_MEMMOVE_THRESHOLD); vec_trace_set_global(NULL); vec_free(v));
+    vec_insert(v, 1, &i);
+    TEST_ASSERT_CLEAN(trace_local.count == 1 && trace_local.event == VEC_EVENT_MEMMOVE && trace_local.bytes == 5 * sizeof(int), vec_trace_set_memmove_threshold(VEC_TRACE_MEMMOVE_THRESHOLD); vec_trace_set_global(NULL); vec_free(v));
+    TEST_ASSERT_CLEAN(trace_local.old_cap == 16 && trace_local.new_cap == 16, vec_trace_set_memmove_threshold(VEC_TRACE_MEMMOVE_THRESHOLD); vec_trace_set_global(NULL); vec_free(v));
+    vec_trace_set_memmove_threshold(VEC_TRACE_MEMMOVE_THRESHOLD);
+
+    /* copies keep the shrink policy, freeing does not shrink first */
+    v->shrink = vec_shrink_hysteresis;
+    Vec *copy = vec_copy(v);
+    TEST_ASSERT_CLEAN(copy->shrink == vec_shrink_hysteresis, vec_trace_set_global(NULL); vec_free(v); vec_free(copy));
+    vec_free(copy);
+    trace_local.count = 0;
+    trace_global.count = 0;
+    vec_free(v);
+    TEST_ASSERT_CLEAN(trace_local.count == 0 && trace_global.count == 0, vec_trace_set_global(NULL));
+
+    /* vectors without their own hook use the global one */
+    w = vec_new(4, sizeof(int), vec_int_cmp, NULL, NULL);
+    TEST_ASSERT_CLEAN(trace_global.count == 1 && trace_global.event == VEC_EVENT_GROW && trace_global.old_cap == 0 && trace_global.tag == NULL, vec_trace_set_global(NULL); vec_free(w));
+    w->trace_tag = "global";
+    for (i = 0; i < 5; i++)
+        V_ADD(w, &i);
+    TEST_ASSERT_CLEAN(trace_global.count == 2 && trace_global.new_cap == 8 && trace_global.cap_in_hook == 8 && strcmp(trace_global.tag, "global") == 0, vec_trace_set_global(NULL); vec_free(w));
+    vec_trace_set_global(NULL);
+    vec_free(w);
+
+    /* the trace file holds one record per event in the layout trace report.c reads */
+    TEST_ASSERT_CLEAN(vec_trace_file_open(path) == 0, (void)0);
+    w = vec_new(4, sizeof(int), vec_int_cmp, NULL, NULL);
+    w->trace_tag = "file";
+    for (i = 0; i < 5; i++)
+        V_ADD(w, &i);
+    vec_free(w);
+    vec_trace_file_close();
+
+    byte header[12], record[32];
+    char tag[64];
+    FILE *f = fopen(path, "rb");
+    TEST_ASSERT_CLEAN(f, remove(path));
+    TEST_ASSERT_CLEAN(fread(header, 1, sizeof(header), f) == sizeof(header) && memcmp(header, "VECTRACE", 8) == 0 && trace_get_le(header + 8, 4) == 1, fclose(f); remove(path));
+    TEST_ASSERT_CLEAN(trace_read_record(f, record, tag) && record[0] == VEC_EVENT_GROW && tag[0] == '\0', fclose(f); remove(path));
+    TEST_ASSERT_CLEAN(trace_get_le(record + 4, 4) == sizeof(int) && trace_get_le(record + 8, 8) == 0 && trace_get_le(record + 16, 8) == 4, fclose(f); remove(path));
+    TEST_ASSERT_CLEAN(trace_read_record(f, record, tag) && record[0] == VEC_EVENT_GROW && strcmp(tag, "file") == 0, fclose(f); remove(path));
+    TEST_ASSERT_CLEAN(trace_get_le(record + 8, 8) == 4 && trace_get_le(record + 16, 8) == 8 && trace_get_le(record + 24, 8) == 8 * sizeof(int), fclose(f); remove(path));
+    TEST_ASSERT_CLEAN(!trace_read_record(f, record, tag), fclose(f); remove(path));
+    fclose(f);
+    remove(path);
+    TEST_PASS();
+}
+
 TEST_SUITE_MAKE(Vec)
 {
     TEST_SUITE_INIT(Vec);
@@ -107,6 +1181,33 @@ TEST_SUITE_MAKE(Vec)
     TEST_SUITE_LINK(Vec, Insert_Vec);
     TEST_SUITE_LINK(Vec, Str_Vec);
     TEST_SUITE_LINK(Vec, Rev_Vec);
+    TEST_SUITE_LINK(Vec, Iter_Vec);
+    TEST_SUITE_LINK(Vec, Remove_If_Vec);
+    TEST_SUITE_LINK(Vec, Insert_N_Vec);
+    TEST_SUITE_LINK(Vec, Heap_Vec);
+    TEST_SUITE_LINK(Vec, Select_Vec);
+    TEST_SUITE_LINK(Vec, Set_Vec);
+    TEST_SUITE_LINK(Vec, Stable_Sort_Vec);
+    TEST_SUITE_LINK(Vec, Aligned_Vec);
+    TEST_SUITE_LINK(Vec, Emplace_Vec);
+    TEST_SUITE_LINK(Vec, Shrink_Vec);
+    TEST_SUITE_LINK(Vec, Zero_Cap_Vec);
+    TEST_SUITE_LINK(Vec, Rotate_Vec);
+    TEST_SUITE_LINK(Vec, SoA_Vec);
+    TEST_SUITE_LINK(Vec, Bit_Vec);
+    TEST_SUITE_LINK(Vec, Pool_Str_Vec);
+    TEST_SUITE_LINK(Vec, Free_Range_Vec);
+    TEST_SUITE_LINK(Vec, Slot_Map_Vec);
+    TEST_SUITE_LINK(Vec, Compressed_Vec);
+    TEST_SUITE_LINK(Vec, Compressed_Width_Vec);
+    TEST_SUITE_LINK(Vec, Search_Index_Vec);
+    TEST_SUITE_LINK(Vec, Numeric_Vec);
+    TEST_SUITE_LINK(Vec, Copy_Vec);
+    TEST_SUITE_LINK(Vec, Mmap_Vec);
+#ifdef VEC_ENABLE_STATS
+    TEST_SUITE_LINK(Vec, Stats_Vec);
+#endif
+    TEST_SUITE_LINK(Vec, Trace_Vec);
     TEST_SUITE_END(Vec);
 }
 
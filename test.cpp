@@ -0,0 +1,166 @@
+/*
+    Tests for the C++ wrapper (vector.hpp), built with the C library:
+        cc -c vector.c -o vector.o
+        c++ -std=c++11 test.cpp vector.o -o test_cpp -lpthread
+*/
+#include "vector.hpp"
+#include <algorithm>
+#include <cstdint>
+#define CTF_TEST_NAMES
+#include "../Testing/ctf.h"
+
+struct alignas(64) Wide
+{
+    int value;
+};
+
+struct Pair
+{
+    int a, b;
+    Pair() : a(-1), b(-1) {}
+    Pair(int a_, int b_) : a(a_), b(b_) {}
+};
+
+TEST_MAKE(Move_Vector)
+{
+    Vector<int> a;
+    for (int i = 0; i < 50; i++)
+        a.push_back(i);
+    Vec *raw = a.get();
+    Vector<int> b(std::move(a));
+    TEST_ASSERT_CLEAN(b.get() == raw && a.get() == nullptr && b.size() == 50 && b[49] == 49, (void)0);
+    Vector<int> c(4);
+    c.push_back(7);
+    c = std::move(b);
+    TEST_ASSERT_CLEAN(c.get() == raw && c.size() == 50 && c.front() == 0 && c.back() == 49, (void)0);
+    /* the moved from Vector can be assigned to again */
+    a = Vector<int>(8);
+    a.push_back(3);
+    TEST_ASSERT_CLEAN(a.size() == 1 && a[0] == 3, (void)0);
+    TEST_PASS();
+}
+
+TEST_MAKE(Adopt_Release_Vector)
+{
+    Vec *v = vec_new(4, sizeof(int), vec_int_cmp, NULL, NULL);
+    int i;
+    for (i = 0; i < 10; i++)
+        V_ADD(v, &i);
+    Vector<int> w = Vector<int>::adopt(v);
+    TEST_ASSERT_CLEAN(w.get() == v && w.size() == 10 && w[9] == 9, (void)0);
+    w.push_back(10);
+    Vec *back = w.release();
+    TEST_ASSERT_CLEAN(back == v && w.get() == nullptr && back->len == 11, vec_free(back));
+    TEST_ASSERT_CLEAN(*(int *)vec_at(back, 10) == 10, vec_free(back));
+    /* and the C side can hand it over again */
+    Vector<int> again = Vector<int>::adopt(back);
+    TEST_ASSERT_CLEAN(again.size() == 11 && again.get()->cmp == vec_int_cmp, (void)0);
+    TEST_PASS();
+}
+
+TEST_MAKE(Clone_Vector)
+{
+    Vec *v = vec_new(4, sizeof(int), vec_int_cmp, NULL, NULL);
+    Vector<int> a = Vector<int>::adopt(v);
+    for (int i = 0; i < 30; i++)
+        a.push_back(i * 3);
+    Vector<int> b = a.clone();
+    TEST_ASSERT_CLEAN(b.get() != a.get() && b.data() != a.data() && b.size() == 30, (void)0);
+    TEST_ASSERT_CLEAN(std::equal(a.begin(), a.end(), b.begin()) && b.get()->cmp == vec_int_cmp, (void)0);
+    b[0] = 100;
+    TEST_ASSERT_CLEAN(a[0] == 0, (void)0);
+    TEST_PASS();
+}
+
+TEST_MAKE(Emplace_Resize_Vector)
+{
+    Vector<Pair> v(2);
+    for (int i = 0; i < 20; i++)
+    {
+        Pair &p = v.emplace_back(i, i * 2);
+        TEST_ASSERT_CLEAN(&p == &v.back() && p.a == i && p.b == i * 2, (void)0);
+    }
+    /* growing value initializes, shrinking drops the tail */
+    v.resize(25);
+    TEST_ASSERT_CLEAN(v.size() == 25 && v[19].b == 38 && v[20].a == -1 && v[24].b == -1, (void)0);
+    v.resize(5);
+    TEST_ASSERT_CLEAN(v.size() == 5 && v[4].a == 4, (void)0);
+    Vector<int> z;
+    z.resize(100);
+    TEST_ASSERT_CLEAN(z.size() == 100 && std::count(z.begin(), z.end(), 0) == 100, (void)0);
+    TEST_PASS();
+}
+
+TEST_MAKE(Insert_Erase_Vector)
+{
+    Vector<int> v;
+    for (int i = 0; i < 10; i++)
+        v.push_back(i);
+    Vector<int>::iterator it = v.insert(v.begin() + 3, 100);
+    TEST_ASSERT_CLEAN(*it == 100 && v.size() == 11 && v[3] == 100 && v[4] == 3, (void)0);
+    /* inserting an element of the vector itself while it grows */
+    while (v.size() < v.capacity())
+        v.push_back(0);
+    v.insert(v.begin(), v[3]);
+    TEST_ASSERT_CLEAN(v[0] == 100 && v[4] == 100, (void)0);
+    int more[] = {-1, -2, -3};
+    it = v.insert(v.begin() + 1, more, more + 3);
+    TEST_ASSERT_CLEAN(*it == -1 && v[2] == -2 && v[3] == -3 && v[4] == 0, (void)0);
+    size_t len = v.size();
+    it = v.erase(v.begin());
+    TEST_ASSERT_CLEAN(*it == -1 && v.size() == len - 1, (void)0);
+    it = v.erase(v.begin(), v.begin() + 3);
+    TEST_ASSERT_CLEAN(*it == 0 && v[1] == 1 && v[3] == 100 && v.size() == len - 4, (void)0);
+    TEST_PASS();
+}
+
+TEST_MAKE(Sort_Vector)
+{
+    Vector<int> v;
+    for (int i = 0; i < 1000; i++)
+        v.push_back((i * 7919) % 1000);
+    std::sort(v.begin(), v.end());
+    for (int i = 0; i < 1000; i++)
+        TEST_ASSERT_CLEAN(v[i] == i, (void)0);
+    TEST_ASSERT_CLEAN(std::lower_bound(v.cbegin(), v.cend(), 500) == v.cbegin() + 500, (void)0);
+    int sum = 0;
+    for (int x : v)
+        sum += x;
+    TEST_ASSERT_CLEAN(sum == 999 * 1000 / 2, (void)0);
+    TEST_PASS();
+}
+
+TEST_MAKE(Aligned_Vector)
+{
+    Vector<Wide> v(1);
+    for (int i = 0; i < 100; i++)
+    {
+        Wide w;
+        w.value = i;
+        v.push_back(w);
+        TEST_ASSERT_CLEAN(reinterpret_cast<uintptr_t>(v.data()) % alignof(Wide) == 0, (void)0);
+    }
+    TEST_ASSERT_CLEAN(v.get()->align == alignof(Wide) && v[99].value == 99, (void)0);
+    Vector<Wide> c = v.clone();
+    TEST_ASSERT_CLEAN(reinterpret_cast<uintptr_t>(c.data()) % alignof(Wide) == 0 && c[50].value == 50, (void)0);
+    TEST_PASS();
+}
+
+TEST_SUITE_MAKE(Vector)
+{
+    TEST_SUITE_INIT(Vector);
+    TEST_SUITE_LINK(Vector, Move_Vector);
+    TEST_SUITE_LINK(Vector, Adopt_Release_Vector);
+    TEST_SUITE_LINK(Vector, Clone_Vector);
+    TEST_SUITE_LINK(Vector, Emplace_Resize_Vector);
+    TEST_SUITE_LINK(Vector, Insert_Erase_Vector);
+    TEST_SUITE_LINK(Vector, Sort_Vector);
+    TEST_SUITE_LINK(Vector, Aligned_Vector);
+    TEST_SUITE_END(Vector);
+}
+
+int main()
+{
+    TEST_SUITE_RUN(Vector);
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file trace report.c
+ * @brief Summarizes a trace file written by vec_trace_file_open, listing the tags responsible
+ * for the most resize and memmove traffic.
+ *
+ * @details Build with the vector: cc "trace report.c" vector.c -o trace_report
+ * Usage: trace_report <trace file> [number of rows, default 20]
+ */
+
+#include "vector.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct trace_row
+{
+    char *tag;
+    VecEvent event;
+    size_t count;
+    uint64_t bytes;     /* sum of the bytes field of the records */
+    uint64_t max_bytes; /* largest single event */
+};
+
+static const char *event_name(VecEvent event)
+{
+    switch (event)
+    {
+    case VEC_EVENT_GROW:
+        return "grow";
+    case VEC_EVENT_SHRINK:
+        return "shrink";
+    case VEC_EVENT_MEMMOVE:
+        return "memmove";
+    }
+    return "unknown";
+}
+
+static void free_row(const void *data)
+{
+    free(((struct trace_row *)data)->tag);
+}
+
+/* rows are found by tag and event */
+static int row_key_cmp(const void *a, const void *b)
+{
+    const struct trace_row *r0 = a, *r1 = b;
+    if (r0->event != r1->event)
+        return r0->event < r1->event ? -1 : 1;
+    return strcmp(r0->tag, r1->tag);
+}
+
+/* sorted by bytes, largest first */
+static int row_bytes_cmp(const void *a, const void *b)
+{
+    const struct trace_row *r0 = a, *r1 = b;
+    if (r0->bytes == r1->bytes)
+        return 0;
+    return r0->bytes < r1->bytes ? 1 : -1;
+}
+
+static uint64_t get_le(const unsigned char *src, size_t len)
+{
+    uint64_t value = 0;
+    while (len--)
+        value = (value << 8) | src[len];
+    return value;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace file> [rows]\n", argv[0]);
+        return 1;
+    }
+    size_t rows = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 20;
+    FILE *f = fopen(argv[1], "rb");
+    if (!f)
+    {
+        perror("trace report: Could not open trace file.");
+        return 1;
+    }
+    unsigned char header[12], record[32];
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) || memcmp(header, "VECTRACE", 8) != 0 || get_le(header + 8, 4) != 1)
+    {
+        fprintf(stderr, "%s is not a version 1 vec trace file\n", argv[1]);
+        fclose(f);
+        return 1;
+    }
+
+    Vec *table = vec_new(VECTOR_DEFAULT_CAP, sizeof(struct trace_row), row_key_cmp, NULL, free_row);
+    size_t records = 0;
+    while (fread(record, 1, sizeof(record), f) == sizeof(record))
+    {
+        size_t tag_len = (size_t)get_le(record + 2, 2);
+        char *tag = malloc(tag_len + 1);
+        if (!tag || fread(tag, 1, tag_len, f) != tag_len)
+        {
+            free(tag);
+            break;
+        }
+        tag[tag_len] = '\0';
+        struct trace_row key = {.tag = tag, .event = (VecEvent)record[0]};
+        struct trace_row *row = vec_find(table, &key);
+        if (row)
+        {
+            free(tag);
+        }
+        else
+        {
+            V_ADD(table, &key);
+            row = vec_at(table, table->len - 1);
+        }
+        uint64_t bytes = get_le(record + 24, 8);
+        row->count++;
+        row->bytes += bytes;
+        if (bytes > row->max_bytes)
+            row->max_bytes = bytes;
+        records++;
+    }
+    fclose(f);
+
+    table->cmp = row_bytes_cmp;
+    vec_sort(table);
+    printf("%zu events, top %zu offenders by bytes\n", records, rows < table->len ? rows : table->len);
+    printf("%-8s %-32s %10s %16s %16s\n", "event", "tag", "count", "bytes", "max bytes");
+    size_t i;
+    for (i = 0; i < table->len && i < rows; i++)
+    {
+        struct trace_row *row = vec_at(table, i);
+        printf("%-8s %-32s %10zu %16llu %16llu\n", event_name(row->event), row->tag[0] ? row->tag : "(untagged)",
+               row->count, (unsigned long long)row->bytes, (unsigned long long)row->max_bytes);
+    }
+    vec_free(table);
+    return 0;
+}
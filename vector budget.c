@@ -0,0 +1,68 @@
+#include "vector budget.h"
+
+static VecBudget vec_global_budget = {.name = "global"};
+
+void vec_budget_init(VecBudget *b, const char *name, size_t soft_limit, size_t hard_limit)
+{
+    *b = (VecBudget){.name = name,
+                     .soft_limit = soft_limit,
+                     .hard_limit = hard_limit};
+}
+
+VecBudget *vec_budget_global(void)
+{
+    return &vec_global_budget;
+}
+
+static void budget_add(VecBudget *b, size_t bytes)
+{
+    b->bytes += bytes;
+    if (b->bytes > b->peak)
+        b->peak = b->bytes;
+}
+
+static void budget_sub(VecBudget *b, size_t bytes)
+{
+    b->bytes = bytes > b->bytes ? 0 : b->bytes - bytes;
+}
+
+/* gives the soft limit callback a chance to release memory, then checks the hard limit */
+static int budget_allows(VecBudget *b, size_t delta)
+{
+    if (b->soft_limit && b->on_soft_limit && b->bytes <= b->soft_limit && b->bytes + delta > b->soft_limit)
+        b->on_soft_limit(b, delta, b->ctx);
+    return !b->hard_limit || b->bytes + delta <= b->hard_limit;
+}
+
+int vec_budget_charge(VecBudget *group, size_t old_bytes, size_t new_bytes)
+{
+    VecBudget *global = &vec_global_budget;
+    if (group == global)
+        group = NULL;
+    if (new_bytes <= old_bytes)
+    {
+        if (group)
+            budget_sub(group, old_bytes - new_bytes);
+        budget_sub(global, old_bytes - new_bytes);
+        return 0;
+    }
+    size_t delta = new_bytes - old_bytes;
+    if (group && !budget_allows(group, delta))
+        return 1;
+    if (!budget_allows(global, delta))
+        return 1;
+    if (group)
+        budget_add(group, delta);
+    budget_add(global, delta);
+    return 0;
+}
+
+void vec_budget_move(VecBudget *from, VecBudget *to, size_t bytes)
+{
+    if (from == to)
+        return;
+    if (from && from != &vec_global_budget)
+        budget_sub(from, bytes);
+    if (to && to != &vec_global_budget)
+        budget_add(to, bytes);
+}
@@ -0,0 +1,84 @@
+/**
+ * @file vector budget.h
+ * @brief Byte accounting and memory limits shared by every vector allocation.
+ *
+ * @details Define VEC_ENABLE_BUDGET (for every file that includes vector.h or vector safe.h) and link
+ * vector budget.c to charge each resize of a vector's data to the global budget and to the vector's group.
+ * Going over a hard limit fails the allocation: vector safe.h returns FAILED_ALLOC, vector.h asserts.
+ * Going over a soft limit calls the budget's callback first so it can trim caches.
+ *
+ * @warning The counters are not synchronized between threads.
+ */
+
+#ifndef VECTOR_BUDGET_H_
+#define VECTOR_BUDGET_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+    typedef struct VecBudget VecBudget;
+
+    /**
+     * @brief Called when a charge of requested bytes is about to take budget over its soft limit.
+     *
+     */
+    typedef void (*vec_soft_limit_func)(VecBudget *budget, size_t requested, void *ctx);
+
+    struct VecBudget
+    {
+        const char *name;
+        size_t bytes;      /* bytes currently allocated by the vectors charged to this budget */
+        size_t peak;       /* largest value bytes reached */
+        size_t soft_limit; /* 0 for none */
+        size_t hard_limit; /* 0 for none */
+        vec_soft_limit_func on_soft_limit;
+        void *ctx; /* handed to on_soft_limit */
+    };
+
+    /**
+     * @brief Initializes a group budget. Vectors join it through vec_set_budget and are also charged to the global budget.
+     *
+     * @param b Budget to initialize.
+     * @param name Name for reports, not copied.
+     * @param soft_limit Bytes past which on_soft_limit is called, 0 for none.
+     * @param hard_limit Bytes past which allocations fail, 0 for none.
+     */
+    void vec_budget_init(VecBudget *b, const char *name, size_t soft_limit, size_t hard_limit);
+
+    /**
+     * @brief Returns the process wide budget every vector is charged to. Its limits start at 0 (none).
+     *
+     * @return VecBudget*
+     */
+    VecBudget *vec_budget_global(void);
+
+    /**
+     * @brief Accounts for an allocation changing from old_bytes to new_bytes.
+     *
+     * @param group Group of the vector, NULL when it only counts against the global budget.
+     * @param old_bytes Previous size of the allocation.
+     * @param new_bytes Requested size of the allocation.
+     * @return int 0 when the change was charged, 1 when it would exceed a hard limit and nothing was charged.
+     *
+     * @details Used by the vector implementations, shrinking always succeeds.
+     */
+    int vec_budget_charge(VecBudget *group, size_t old_bytes, size_t new_bytes);
+
+    /**
+     * @brief Moves bytes from one group to another without checking limits, the global budget is unchanged.
+     *
+     * @param from Group the bytes were charged to, NULL for none.
+     * @param to Group to charge, NULL for none.
+     * @param bytes Bytes to move.
+     */
+    void vec_budget_move(VecBudget *from, VecBudget *to, size_t bytes);
+
+#ifdef __cplusplus
+} /* Extern "C" */
+#endif
+
+#endif /* VECTOR_BUDGET_H_ */
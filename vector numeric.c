@@ -0,0 +1,489 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* sysconf(_SC_NPROCESSORS_ONLN) */
+#endif
+
+#include "vector numeric.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#if !defined(VEC_DISABLE_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#include <pthread.h>
+#include <unistd.h>
+#define NUMERIC_THREADS
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NUMERIC_AVX2
+#define NUMERIC_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#define SIGN ((uint64_t)1 << 63)
+
+/*
+    Kernels compare elements as keys, unsigned 64 bit integers ordered like the elements.
+    The key of an unsigned element is its value, a signed element is sign extended and gets its sign bit flipped.
+    The difference of two keys is the difference of their elements, which the histogram relies on.
+*/
+typedef struct NumericOps
+{
+    uint64_t (*sum)(const void *p, size_t n);
+    void (*minmax)(const void *p, size_t n, uint64_t *min, uint64_t *max);
+    size_t (*find)(const void *p, size_t n, uint64_t key);
+    void (*scan)(void *p, size_t n, uint64_t carry);
+    void (*hist)(const void *p, size_t n, uint64_t lo, uint64_t width, size_t *counts, size_t nbins);
+    uint64_t (*key)(const void *p);
+    void (*store)(void *p, uint64_t key);
+} NumericOps;
+
+/* scalar kernels for elements of type T, summed in the unsigned type U, FLIP is SIGN for signed types */
+#define NUMERIC_SCALAR(name, T, U, FLIP)                                                                     \
+    static uint64_t name##_key(const void *p)                                                                \
+    {                                                                                                        \
+        T x;                                                                                                 \
+        memcpy(&x, p, sizeof(T));                                                                            \
+        return (uint64_t)x ^ FLIP;                                                                           \
+    }                                                                                                        \
+    static void name##_store(void *p, uint64_t key)                                                          \
+    {                                                                                                        \
+        T x = (T)(key ^ FLIP);                                                                               \
+        memcpy(p, &x, sizeof(T));                                                                            \
+    }                                                                                                        \
+    static uint64_t name##_sum(const void *p, size_t n)                                                      \
+    {                                                                                                        \
+        const T *a = p;                                                                                      \
+        uint64_t s = 0;                                                                                      \
+        size_t i;                                                                                            \
+        for (i = 0; i < n; i++)                                                                              \
+            s += (uint64_t)a[i];                                                                             \
+        return s;                                                                                            \
+    }                                                                                                        \
+    static void name##_minmax(const void *p, size_t n, uint64_t *min, uint64_t *max)                         \
+    {                                                                                                        \
+        const T *a = p;                                                                                      \
+        uint64_t lo = UINT64_MAX, hi = 0, k;                                                                 \
+        size_t i;                                                                                            \
+        for (i = 0; i < n; i++)                                                                              \
+        {                                                                                                    \
+            k = (uint64_t)a[i] ^ FLIP;                                                                       \
+            lo = k < lo ? k : lo;                                                                            \
+            hi = k > hi ? k : hi;                                                                            \
+        }                                                                                                    \
+        *min = lo;                                                                                           \
+        *max = hi;                                                                                           \
+    }                                                                                                        \
+    static size_t name##_find(const void *p, size_t n, uint64_t key)                                         \
+    {                                                                                                        \
+        const T *a = p;                                                                                      \
+        size_t i;                                                                                            \
+        for (i = 0; i < n; i++)                                                                              \
+            if (((uint64_t)a[i] ^ FLIP) == key)                                                              \
+                return i;                                                                                    \
+        return n;                                                                                            \
+    }                                                                                                        \
+    static void name##_scan(void *p, size_t n, uint64_t carry)                                               \
+    {                                                                                                        \
+        T *a = p;                                                                                            \
+        U s = (U)carry;                                                                                      \
+        size_t i;                                                                                            \
+        for (i = 0; i < n; i++)                                                                              \
+        {                                                                                                    \
+            s += (U)a[i];                                                                                    \
+            a[i] = (T)s;                                                                                     \
+        }                                                                                                    \
+    }                                                                                                        \
+    static void name##_hist(const void *p, size_t n, uint64_t lo, uint64_t width, size_t *counts, size_t nbins) \
+    {                                                                                                        \
+        const T *a = p;                                                                                      \
+        int pow2 = !(width & (width - 1));                                                                   \
+        unsigned shift = 0;                                                                                  \
+        uint64_t k, bin;                                                                                     \
+        size_t i;                                                                                            \
+        while (pow2 && ((uint64_t)1 << shift) < width)                                                       \
+            shift++;                                                                                         \
+        for (i = 0; i < n; i++)                                                                              \
+        {                                                                                                    \
+            k = (uint64_t)a[i] ^ FLIP;                                                                       \
+            if (k < lo)                                                                                      \
+                continue;                                                                                    \
+            bin = pow2 ? (k - lo) >> shift : (k - lo) / width;                                               \
+            if (bin < (uint64_t)nbins)                                                                       \
+                counts[bin]++;                                                                               \
+        }                                                                                                    \
+    }
+
+NUMERIC_SCALAR(int, int, unsigned int, SIGN)
+NUMERIC_SCALAR(uint, unsigned int, unsigned int, 0)
+NUMERIC_SCALAR(ll, long long, unsigned long long, SIGN)
+NUMERIC_SCALAR(ull, unsigned long long, unsigned long long, 0)
+
+static const NumericOps numeric_scalar_ops[] = {
+    {int_sum, int_minmax, int_find, int_scan, int_hist, int_key, int_store},
+    {uint_sum, uint_minmax, uint_find, uint_scan, uint_hist, uint_key, uint_store},
+    {ll_sum, ll_minmax, ll_find, ll_scan, ll_hist, ll_key, ll_store},
+    {ull_sum, ull_minmax, ull_find, ull_scan, ull_hist, ull_key, ull_store},
+};
+
+#ifdef NUMERIC_AVX2
+/* 32 bit elements are widened to 64 bit lanes, two accumulators keep two loads in flight */
+#define NUMERIC_SUM32_AVX2(name, T, WIDEN)                                               \
+    NUMERIC_TARGET_AVX2 static uint64_t name##_sum_avx2(const void *p, size_t n)         \
+    {                                                                                    \
+        const T *a = p;                                                                  \
+        __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();                \
+        uint64_t lanes[4];                                                               \
+        size_t i;                                                                        \
+        for (i = 0; i + 8 <= n; i += 8)                                                  \
+        {                                                                                \
+            s0 = _mm256_add_epi64(s0, WIDEN(_mm_loadu_si128((const __m128i *)(a + i)))); \
+            s1 = _mm256_add_epi64(s1, WIDEN(_mm_loadu_si128((const __m128i *)(a + i + 4)))); \
+        }                                                                                \
+        _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(s0, s1));                 \
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + name##_sum(a + i, n - i);     \
+    }
+
+#define NUMERIC_MINMAX32_AVX2(name, T, MIN, MAX)                                                      \
+    NUMERIC_TARGET_AVX2 static void name##_minmax_avx2(const void *p, size_t n, uint64_t *min, uint64_t *max) \
+    {                                                                                                 \
+        const T *a = p;                                                                               \
+        T lanes_min[8], lanes_max[8];                                                                 \
+        uint64_t lo, hi, l, h;                                                                        \
+        size_t i;                                                                                     \
+        if (n < 8)                                                                                    \
+        {                                                                                             \
+            name##_minmax(p, n, min, max);                                                            \
+            return;                                                                                   \
+        }                                                                                             \
+        __m256i mn = _mm256_loadu_si256((const __m256i *)a), mx = mn, x;                              \
+        for (i = 8; i + 8 <= n; i += 8)                                                               \
+        {                                                                                             \
+            x = _mm256_loadu_si256((const __m256i *)(a + i));                                         \
+            mn = MIN(mn, x);                                                                          \
+            mx = MAX(mx, x);                                                                          \
+        }                                                                                             \
+        _mm256_storeu_si256((__m256i *)lanes_min, mn);                                                \
+        _mm256_storeu_si256((__m256i *)lanes_max, mx);                                                \
+        name##_minmax(a + i, n - i, &lo, &hi);                                                        \
+        name##_minmax(lanes_min, 8, &l, &h);                                                          \
+        *min = l < lo ? l : lo;                                                                       \
+        name##_minmax(lanes_max, 8, &l, &h);                                                          \
+        *max = h > hi ? h : hi;                                                                       \
+    }
+
+/* AVX2 has no unsigned 64 bit compare, unsigned values are biased by INT64_MIN so the signed one orders them.
+    The key of a lane is then lane ^ SIGN for both types */
+#define NUMERIC_MINMAX64_AVX2(name, BIAS)                                                             \
+    NUMERIC_TARGET_AVX2 static void name##_minmax_avx2(const void *p, size_t n, uint64_t *min, uint64_t *max) \
+    {                                                                                                 \
+        const uint64_t *a = p;                                                                        \
+        uint64_t lanes_min[4], lanes_max[4], lo, hi, k;                                               \
+        size_t i, j;                                                                                  \
+        if (n < 4)                                                                                    \
+        {                                                                                             \
+            name##_minmax(p, n, min, max);                                                            \
+            return;                                                                                   \
+        }                                                                                             \
+        __m256i bias = _mm256_set1_epi64x(BIAS), x;                                                   \
+        __m256i mn = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)a), bias), mx = mn;         \
+        for (i = 4; i + 4 <= n; i += 4)                                                               \
+        {                                                                                             \
+            x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i)), bias);                 \
+            mn = _mm256_blendv_epi8(mn, x, _mm256_cmpgt_epi64(mn, x));                                \
+            mx = _mm256_blendv_epi8(mx, x, _mm256_cmpgt_epi64(x, mx));                                \
+        }                                                                                             \
+        _mm256_storeu_si256((__m256i *)lanes_min, mn);                                                \
+        _mm256_storeu_si256((__m256i *)lanes_max, mx);                                                \
+        name##_minmax(a + i, n - i, &lo, &hi);                                                        \
+        for (j = 0; j < 4; j++)                                                                       \
+        {                                                                                             \
+            k = lanes_min[j] ^ SIGN;                                                                  \
+            lo = k < lo ? k : lo;                                                                     \
+            k = lanes_max[j] ^ SIGN;                                                                  \
+            hi = k > hi ? k : hi;                                                                     \
+        }                                                                                             \
+        *min = lo;                                                                                    \
+        *max = hi;                                                                                    \
+    }
+
+NUMERIC_SUM32_AVX2(int, int, _mm256_cvtepi32_epi64)
+NUMERIC_SUM32_AVX2(uint, unsigned int, _mm256_cvtepu32_epi64)
+NUMERIC_MINMAX32_AVX2(int, int, _mm256_min_epi32, _mm256_max_epi32)
+NUMERIC_MINMAX32_AVX2(uint, unsigned int, _mm256_min_epu32, _mm256_max_epu32)
+NUMERIC_MINMAX64_AVX2(ll, 0)
+NUMERIC_MINMAX64_AVX2(ull, INT64_MIN)
+
+/* signed and unsigned 64 bit sums are the same bits */
+NUMERIC_TARGET_AVX2 static uint64_t ull_sum_avx2(const void *p, size_t n)
+{
+    const uint64_t *a = p;
+    __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+    uint64_t lanes[4];
+    size_t i;
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        s0 = _mm256_add_epi64(s0, _mm256_loadu_si256((const __m256i *)(a + i)));
+        s1 = _mm256_add_epi64(s1, _mm256_loadu_si256((const __m256i *)(a + i + 4)));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(s0, s1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ull_sum(a + i, n - i);
+}
+
+/* the scan and histogram are bound by their serial dependency and scattered increments, they stay scalar */
+static const NumericOps numeric_avx2_ops[] = {
+    {int_sum_avx2, int_minmax_avx2, int_find, int_scan, int_hist, int_key, int_store},
+    {uint_sum_avx2, uint_minmax_avx2, uint_find, uint_scan, uint_hist, uint_key, uint_store},
+    {ull_sum_avx2, ll_minmax_avx2, ll_find, ll_scan, ll_hist, ll_key, ll_store},
+    {ull_sum_avx2, ull_minmax_avx2, ull_find, ull_scan, ull_hist, ull_key, ull_store},
+};
+
+static int numeric_have_avx2(void)
+{
+    static int have = -1;
+    if (have < 0)
+    {
+        __builtin_cpu_init();
+        have = __builtin_cpu_supports("avx2") != 0;
+    }
+    return have;
+}
+#endif
+
+/* the kernels for the element type of v, NULL when it is not a vector of built in integers */
+static const NumericOps *numeric_ops(Vec *v)
+{
+    size_t kind;
+    if (v->cmp == vec_int_cmp && v->elem_size == sizeof(int))
+        kind = 0;
+    else if (v->cmp == vec_uint_cmp && v->elem_size == sizeof(unsigned int))
+        kind = 1;
+    else if (v->cmp == vec_ll_cmp && v->elem_size == sizeof(long long))
+        kind = 2;
+    else if (v->cmp == vec_ull_cmp && v->elem_size == sizeof(unsigned long long))
+        kind = 3;
+    else
+        return NULL;
+#ifdef NUMERIC_AVX2
+    if (sizeof(int) == 4 && numeric_have_avx2())
+        return &numeric_avx2_ops[kind];
+#endif
+    return &numeric_scalar_ops[kind];
+}
+
+typedef struct NumericTask NumericTask;
+
+typedef void (*numeric_part_func)(NumericTask *t, size_t part, const byte *first, size_t n);
+
+/* one operation split into parts, a and b hold a result or input per part */
+struct NumericTask
+{
+    const NumericOps *ops;
+    numeric_part_func fn;
+    uint64_t a[VEC_NUMERIC_MAX_THREADS];
+    uint64_t b[VEC_NUMERIC_MAX_THREADS];
+    size_t *counts; /* histogram counts of part 0, the other parts count into scratch */
+    size_t *scratch;
+    uint64_t lo, width;
+    size_t nbins;
+};
+
+typedef struct NumericPart
+{
+    NumericTask *task;
+    size_t part;
+    const byte *first;
+    size_t n;
+} NumericPart;
+
+static void *numeric_part(void *arg)
+{
+    NumericPart *p = arg;
+    p->task->fn(p->task, p->part, p->first, p->n);
+    return NULL;
+}
+
+/* parts to split v into, more than one only for vectors of at least VEC_NUMERIC_THREAD_BYTES */
+static size_t numeric_parts(Vec *v)
+{
+#ifdef NUMERIC_THREADS
+    if (v->len * v->elem_size >= VEC_NUMERIC_THREAD_BYTES)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (cpus > 1)
+            return cpus < VEC_NUMERIC_MAX_THREADS ? (size_t)cpus : VEC_NUMERIC_MAX_THREADS;
+    }
+#else
+    (void)v;
+#endif
+    return 1;
+}
+
+static size_t numeric_part_begin(Vec *v, size_t parts, size_t part)
+{
+    return v->len / parts * part + (part < v->len % parts ? part : v->len % parts);
+}
+
+/* runs t->fn over parts slices of v, the calling thread takes the first and any thread that fails to start */
+static void numeric_run(NumericTask *t, Vec *v, size_t parts)
+{
+    NumericPart p[VEC_NUMERIC_MAX_THREADS];
+    size_t i;
+    for (i = 0; i < parts; i++)
+    {
+        size_t begin = numeric_part_begin(v, parts, i), end = numeric_part_begin(v, parts, i + 1);
+        p[i] = (NumericPart){.task = t, .part = i, .first = v->data + begin * v->elem_size, .n = end - begin};
+    }
+#ifdef NUMERIC_THREADS
+    pthread_t threads[VEC_NUMERIC_MAX_THREADS];
+    int started[VEC_NUMERIC_MAX_THREADS];
+    for (i = 1; i < parts; i++)
+        started[i] = pthread_create(&threads[i], NULL, numeric_part, &p[i]) == 0;
+    numeric_part(&p[0]);
+    for (i = 1; i < parts; i++)
+    {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            numeric_part(&p[i]);
+    }
+#else
+    for (i = 0; i < parts; i++)
+        numeric_part(&p[i]);
+#endif
+}
+
+static void numeric_sum_part(NumericTask *t, size_t part, const byte *first, size_t n)
+{
+    t->a[part] = t->ops->sum(first, n);
+}
+
+static void numeric_minmax_part(NumericTask *t, size_t part, const byte *first, size_t n)
+{
+    t->ops->minmax(first, n, &t->a[part], &t->b[part]);
+}
+
+static void numeric_scan_part(NumericTask *t, size_t part, const byte *first, size_t n)
+{
+    t->ops->scan((void *)first, n, t->a[part]);
+}
+
+static void numeric_hist_part(NumericTask *t, size_t part, const byte *first, size_t n)
+{
+    size_t *counts = part ? t->scratch + (part - 1) * t->nbins : t->counts;
+    t->ops->hist(first, n, t->lo, t->width, counts, t->nbins);
+}
+
+int vec_sum_i64(Vec *v, int64_t *sum)
+{
+    VALIDATE_VECTOR(v);
+    const NumericOps *ops = numeric_ops(v);
+    if (!ops)
+        return 1;
+    NumericTask t = {.ops = ops, .fn = numeric_sum_part};
+    size_t parts = numeric_parts(v), i;
+    uint64_t s = 0;
+    numeric_run(&t, v, parts);
+    for (i = 0; i < parts; i++)
+        s += t.a[i];
+    *sum = (int64_t)s;
+    return 0;
+}
+
+/* fills t.a and t.b with the min and max key of each part */
+static void numeric_minmax(Vec *v, NumericTask *t, size_t parts, uint64_t *min, uint64_t *max)
+{
+    size_t i;
+    numeric_run(t, v, parts);
+    *min = t->a[0];
+    *max = t->b[0];
+    for (i = 1; i < parts; i++)
+    {
+        *min = t->a[i] < *min ? t->a[i] : *min;
+        *max = t->b[i] > *max ? t->b[i] : *max;
+    }
+}
+
+int vec_minmax(Vec *v, void *min, void *max)
+{
+    VALIDATE_VECTOR(v);
+    const NumericOps *ops = numeric_ops(v);
+    if (!ops || !v->len)
+        return 1;
+    NumericTask t = {.ops = ops, .fn = numeric_minmax_part};
+    uint64_t lo, hi;
+    numeric_minmax(v, &t, numeric_parts(v), &lo, &hi);
+    if (min)
+        ops->store(min, lo);
+    if (max)
+        ops->store(max, hi);
+    return 0;
+}
+
+size_t vec_argmin(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    const NumericOps *ops = numeric_ops(v);
+    if (!ops || !v->len)
+        return INVALID_FE_IDX;
+    NumericTask t = {.ops = ops, .fn = numeric_minmax_part};
+    size_t parts = numeric_parts(v), part, begin;
+    uint64_t lo, hi;
+    numeric_minmax(v, &t, parts, &lo, &hi);
+    /* only the first part holding the minimum is searched again */
+    for (part = 0; t.a[part] != lo; part++)
+        ;
+    begin = numeric_part_begin(v, parts, part);
+    return begin + ops->find(v->data + begin * v->elem_size, numeric_part_begin(v, parts, part + 1) - begin, lo);
+}
+
+int vec_prefix_sum(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    const NumericOps *ops = numeric_ops(v);
+    if (!ops)
+        return 1;
+    size_t parts = numeric_parts(v), i;
+    if (parts == 1)
+    {
+        ops->scan(v->data, v->len, 0);
+        return 0;
+    }
+    /* sum every part, then scan every part starting from the sum of the parts before it */
+    NumericTask t = {.ops = ops, .fn = numeric_sum_part};
+    uint64_t carry = 0, s;
+    numeric_run(&t, v, parts);
+    for (i = 0; i < parts; i++)
+    {
+        s = t.a[i];
+        t.a[i] = carry;
+        carry += s;
+    }
+    t.fn = numeric_scan_part;
+    numeric_run(&t, v, parts);
+    return 0;
+}
+
+int vec_histogram(Vec *v, const void *lo, uint64_t width, size_t *counts, size_t nbins)
+{
+    VALIDATE_VECTOR(v);
+    const NumericOps *ops = numeric_ops(v);
+    if (!ops || !width)
+        return 1;
+    memset(counts, 0, nbins * sizeof(size_t));
+    if (!nbins)
+        return 0;
+    size_t parts = numeric_parts(v), i, j;
+    NumericTask t = {.ops = ops, .fn = numeric_hist_part, .counts = counts, .lo = ops->key(lo), .width = width, .nbins = nbins};
+    if (parts > 1)
+    {
+        /* every thread counts into its own bins so no increment is shared */
+        t.scratch = calloc((parts - 1) * nbins, sizeof(size_t));
+        VEC_ASSERT(t.scratch);
+    }
+    numeric_run(&t, v, parts);
+    for (i = 1; i < parts; i++)
+        for (j = 0; j < nbins; j++)
+            counts[j] += t.scratch[(i - 1) * nbins + j];
+    free(t.scratch);
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file vector numeric.h
+ * @brief Reductions, scans and histograms over vectors of built in integers.
+ *
+ * @details These kernels work on vectors whose cmp is vec_int_cmp, vec_uint_cmp, vec_ll_cmp or vec_ull_cmp
+ * with the matching elem_size, which is how the element type is known. Every other vector is refused.
+ * On x86 with GCC or clang the sum and min/max loops have AVX2 versions picked at runtime when the CPU supports them.
+ * Vectors of at least VEC_NUMERIC_THREAD_BYTES are split across threads.
+ * Link vector numeric.c and vector.c, and pthreads on POSIX systems.
+ */
+
+#ifndef VECTOR_NUMERIC_H_
+#define VECTOR_NUMERIC_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "vector.h"
+
+    /*
+        Define VEC_DISABLE_THREADS to always run the kernels on the calling thread.
+        Otherwise vectors of at least VEC_NUMERIC_THREAD_BYTES are split between up to VEC_NUMERIC_MAX_THREADS threads.
+    */
+
+#ifndef VEC_NUMERIC_THREAD_BYTES
+#define VEC_NUMERIC_THREAD_BYTES ((size_t)16 * 1024 * 1024)
+#endif
+
+#ifndef VEC_NUMERIC_MAX_THREADS
+#define VEC_NUMERIC_MAX_THREADS 16
+#endif
+
+    /**
+     * @brief Sums every element as a 64 bit integer.
+     *
+     * @param v Vector of built in integers.
+     * @param sum Receives the sum, wrapping on overflow.
+     * @return int 0 on success, 1 when v is not a vector of built in integers.
+     */
+    int vec_sum_i64(Vec *v, int64_t *sum);
+
+    /**
+     * @brief Finds the smallest and largest element.
+     *
+     * @param v Vector of built in integers.
+     * @param min Receives elem_size bytes of the smallest element, may be NULL.
+     * @param max Receives elem_size bytes of the largest element, may be NULL.
+     * @return int 0 on success, 1 when v is empty or not a vector of built in integers.
+     */
+    int vec_minmax(Vec *v, void *min, void *max);
+
+    /**
+     * @brief Returns the index of the first smallest element.
+     *
+     * @param v Vector of built in integers.
+     * @return size_t INVALID_FE_IDX when v is empty or not a vector of built in integers.
+     */
+    size_t vec_argmin(Vec *v);
+
+    /**
+     * @brief Replaces every element with the sum of it and all elements before it.
+     *
+     * @param v Vector of built in integers, sums wrap in the element type.
+     * @return int 0 on success, 1 when v is not a vector of built in integers.
+     */
+    int vec_prefix_sum(Vec *v);
+
+    /**
+     * @brief Counts the elements falling in each of nbins bins of width values starting at lo.
+     *
+     * @param v Vector of built in integers.
+     * @param lo elem_size bytes holding the first value of bin 0.
+     * @param width Values per bin, a power of two avoids a division per element.
+     * @param counts Receives nbins counts, elements below lo or past the last bin are not counted.
+     * @param nbins Number of bins.
+     * @return int 0 on success, 1 when width is 0 or v is not a vector of built in integers.
+     */
+    int vec_histogram(Vec *v, const void *lo, uint64_t width, size_t *counts, size_t nbins);
+
+#ifdef __cplusplus
+} /* Extern "C" */
+#endif
+
+#endif /* VECTOR_NUMERIC_H_ */
@@ -1,4 +1,4 @@
-#include "vector copy.h"
+#include "vector safe.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -37,6 +37,34 @@
 
 #define VALIDATE_VECTOR(vec) EXIT_IF_NULL(vec)
 
+#define RET_IF_NULL_VEC(vec) \
+    if (vec == NULL)         \
+        return NULL_VEC;
+
+const char *vec_error_to_string(Vec_Error err)
+{
+    switch (err)
+    {
+    case NONE:
+        return "NONE";
+    case IDX_OOB:
+        return "IDX_OOB";
+    case NULL_ARG:
+        return "NULL_ARG";
+    case NULL_VEC:
+        return "NULL_VEC";
+    case EMPTY_VEC:
+        return "EMPTY_VEC";
+    case FAILED_ALLOC:
+        return "FAILED_ALLOC";
+    case MISSING_INTERNAL_FUNC:
+        return "MISSING_INTERNAL_FUNC";
+    case UNKNOWN:
+        return "UNKNOWN";
+    }
+    return "UNKNOWN";
+}
+
 static size_t default_growth_rate(Vec *v)
 {
     return v->capacity * 2;
@@ -58,7 +86,7 @@ static int default_cmp(const void *data0, const void *data1)
 Vec_Error vec_new(Vec* ret, size_t capacity, size_t elem_size, void_cmp_func cmp, vec_growth_rate_func grow, void (*free_entry)(const void *))
 {
     //Vec *p = malloc(sizeof(Vec));
-    VEC_ASSERT(ret);
+    RET_IF_NULL(ret, NULL_ARG);
     *ret = (Vec){.elem_size = elem_size,
                .capacity = 0,
                .len = 0,
@@ -66,15 +94,47 @@ Vec_Error vec_new(Vec* ret, size_t capacity, size_t elem_size, void_cmp_func cmp
                .cmp = cmp ? cmp : NULL,
                .grow = grow ? grow : default_growth_rate,
                .free_entry = free_entry ? free_entry : NULL};
-    vec_resize(ret, capacity);
+    return vec_resize(ret, capacity);
+}
+
+/* all allocations of data go through here, NULL when realloc fails or the budget refuses the new size */
+static byte *vec_realloc_data(Vec *v, size_t new_bytes)
+{
+    size_t old_bytes = v->data ? (v->capacity ? v->capacity : 1) * v->elem_size * sizeof(byte) : 0;
+#ifdef VEC_ENABLE_BUDGET
+    if (vec_budget_charge(v->budget, old_bytes, new_bytes))
+        return NULL;
+    byte *p = (byte *)realloc(v->data, new_bytes);
+    if (!p)
+        vec_budget_charge(v->budget, new_bytes, old_bytes);
+    return p;
+#else
+    (void)old_bytes;
+    return (byte *)realloc(v->data, new_bytes);
+#endif
+}
+
+#ifdef VEC_ENABLE_BUDGET
+Vec_Error vec_set_budget(Vec *v, VecBudget *budget)
+{
+    RET_IF_NULL_VEC(v);
+    if (v->data)
+        vec_budget_move(v->budget, budget, (v->capacity ? v->capacity : 1) * v->elem_size * sizeof(byte));
+    v->budget = budget;
     return NONE;
 }
+#endif
 
 void vec_free(Vec *v)
 {
     VALIDATE_VECTOR(v);
     vec_clear(v);
+#ifdef VEC_ENABLE_BUDGET
+    if (v->data)
+        vec_budget_charge(v->budget, (v->capacity ? v->capacity : 1) * v->elem_size * sizeof(byte), 0);
+#endif
     free(v->data);
+    v->data = NULL;
     /*free(v);*/
 }
 
@@ -93,62 +153,74 @@ void *vec_at_s(Vec *v, size_t index)
     return vec_at(v, index);
 }
 
-void vec_resize(Vec *v, size_t new_cap)
+Vec_Error vec_resize(Vec *v, size_t new_cap)
 {
-    VALIDATE_VECTOR(v);
+    RET_IF_NULL_VEC(v);
     if (new_cap == v->capacity)
-        return;
+        return NONE;
     if (!new_cap)
         new_cap++;
-    byte *new_data = (byte *)realloc(v->data, new_cap * v->elem_size * sizeof(byte));
-    VEC_ASSERT(new_data != NULL && "vec_resize: Failed to resize vec array.");
+    byte *new_data = vec_realloc_data(v, new_cap * v->elem_size * sizeof(byte));
+    if (!new_data)
+        return FAILED_ALLOC;
 
     // Initialize the newly allocated memory
-    size_t old_cap_start = v->capacity * v->elem_size * sizeof(byte);
-    if (old_cap_start < new_cap)
+    if (v->capacity < new_cap)
     {
+        size_t old_cap_start = v->capacity * v->elem_size * sizeof(byte);
         size_t region_len = new_cap - v->capacity;
         memset(new_data + old_cap_start, 0, region_len * v->elem_size * sizeof(byte));
     }
     v->capacity = new_cap;
     v->data = new_data;
+    return NONE;
 }
 
-void vec_push_back(Vec *v, void *data)
+Vec_Error vec_push_back(Vec *v, void *data)
 {
-    VALIDATE_VECTOR(v);
+    RET_IF_NULL_VEC(v);
     if (!data)
-        return;
+        return NULL_ARG;
     if (v->len >= v->capacity)
-        vec_resize(v, v->grow(v));
+    {
+        Vec_Error err = vec_resize(v, v->grow(v));
+        if (V_IS_ERR(err))
+            return err;
+    }
     memcpy(vec_at(v, v->len), data, v->elem_size * sizeof(byte));
     v->len++;
+    return NONE;
 }
 
-void vec_sort(Vec *v)
+Vec_Error vec_sort(Vec *v)
 {
-    VALIDATE_VECTOR(v);
+    RET_IF_NULL_VEC(v);
     if (!v->cmp)
-    {
-        perror("vec_sort: Compare function is undefined.");
-        return;
-    }
+        return MISSING_INTERNAL_FUNC;
     qsort(v->data, v->len, v->elem_size, v->cmp);
+    return NONE;
 }
 
-void vec_insert(Vec *v, size_t index, void *data)
+Vec_Error vec_insert(Vec *v, size_t index, void *data)
 {
-    VALIDATE_VECTOR(v);
+    RET_IF_NULL_VEC(v);
+    if (!data)
+        return NULL_ARG;
     if (index > v->len)
-        return;
+        return IDX_OOB;
 
     if (v->len >= v->capacity)
-        vec_resize(v, v->grow(v));
+    {
+        Vec_Error err = vec_resize(v, v->grow(v));
+        if (V_IS_ERR(err))
+            return err;
+    }
 
     memmove(vec_at(v, index + 1), vec_at(v, index), (v->len - index) * v->elem_size * sizeof(byte));
     memcpy(vec_at(v, index), data, v->elem_size);
 
     v->len++;
+    return NONE;
 }
 
 void vec_clear(Vec *v)
@@ -172,17 +244,19 @@ void vec_clear(Vec *v)
 //     v->len = 0;
 // }
 
-void vec_clamp(Vec *v)
+Vec_Error vec_clamp(Vec *v)
 {
-    VALIDATE_VECTOR(v);
+    RET_IF_NULL_VEC(v);
     byte *tmp;
     if (!v->len)
-        tmp = (byte *)realloc(v->data, v->elem_size * sizeof(byte));
+        tmp = vec_realloc_data(v, v->elem_size * sizeof(byte));
     else
-        tmp = (byte *)realloc(v->data, v->len * v->elem_size * sizeof(byte));
-    VEC_ASSERT(tmp);
+        tmp = vec_realloc_data(v, v->len * v->elem_size * sizeof(byte));
+    if (!tmp)
+        return FAILED_ALLOC;
     v->data = tmp;
     v->capacity = v->len;
+    return NONE;
 }
 
 void *vec_pop_back(Vec *v)
@@ -211,11 +285,11 @@ void *vec_find(Vec *v, void *_find)
     return NULL;
 }
 
-void vec_remove(Vec *v, size_t index)
+Vec_Error vec_remove(Vec *v, size_t index)
 {
-    VALIDATE_VECTOR(v);
+    RET_IF_NULL_VEC(v);
     if (index >= v->len)
-        return;
+        return IDX_OOB;
     if (v->fe_idx != INVALID_FE_IDX)
     {
         v->fe_idx--;
@@ -226,64 +300,66 @@ void vec_remove(Vec *v, size_t index)
     }
 
     v->len--;
+    return NONE;
 }
 
-void vec_remove_fast(Vec *v, size_t index)
+Vec_Error vec_remove_fast(Vec *v, size_t index)
 {
-    VALIDATE_VECTOR(v);
+    RET_IF_NULL_VEC(v);
     if (index >= v->len)
-        return;
+        return IDX_OOB;
     if (v->fe_idx != INVALID_FE_IDX) // allows V_FOR_EACH to remove entries
     {
         v->fe_idx--;
     }
     memcpy(vec_at(v, index), vec_at(v, v->len - 1), v->elem_size * sizeof(byte));
     v->len--;
+    return NONE;
 }
 
-/* Returns heap allocated deep copy */
+/* Returns heap allocated deep copy, NULL on fail */
 Vec *vec_copy(Vec *v)
 {
     VALIDATE_VECTOR(v);
     Vec *ret = (Vec *)malloc(sizeof(Vec));
-    VEC_ASSERT(ret);
-    ret->grow = v->grow;
-    ret->cmp = v->cmp;
-    ret->elem_size = v->elem_size;
-    ret->len = 0;
-    ret->data = NULL;
-    ret->capacity = 0;
-    vec_resize(ret, v->capacity);
-    if (v->capacity == 0)
+    if (!ret)
+        return NULL;
+    *ret = (Vec){.elem_size = v->elem_size,
+                 .capacity = 0,
+                 .len = 0,
+                 .data = NULL,
+                 .cmp = v->cmp,
+                 .grow = v->grow};
+#ifdef VEC_ENABLE_BUDGET
+    ret->budget = v->budget;
+#endif
+    if (V_IS_ERR(vec_resize(ret, v->capacity)))
     {
-        return ret;
+        free(ret);
+        return NULL;
     }
-    VEC_ASSERT(ret->data && ret->capacity == v->capacity);
-    memcpy(ret->data, v->data, v->capacity);
+    memcpy(ret->data, v->data, v->len * v->elem_size);
+    ret->len = v->len;
     return ret;
 }
 
 void vec_reverse(Vec *v)
 {
     VALIDATE_VECTOR(v);
-    byte *start = v->data;
-    byte *end = start + v->capacity - 1;
-
-    while (start < end)
+    size_t i;
+    for (i = 0; i < v->len / 2; i++)
     {
-        byte temp = *start;
-        *start++ = *end;
-        *end-- = temp;
+        vec_swap(v, i, v->len - i - 1);
     }
 }
 
-void vec_swap(Vec *v, size_t idx0, size_t idx1)
+Vec_Error vec_swap(Vec *v, size_t idx0, size_t idx1)
 {
-    VALIDATE_VECTOR(v);
+    RET_IF_NULL_VEC(v);
     if (idx0 >= v->len)
-        return;
+        return IDX_OOB;
     if (idx1 >= v->len)
-        return;
+        return IDX_OOB;
 
     size_t write_size = v->elem_size;
     byte *idx0_entry = vec_at(v, idx0);
@@ -296,6 +372,7 @@ void vec_swap(Vec *v, size_t idx0, size_t idx1)
         idx1_entry[idx] = tmp;
         write_size--;
     }
+    return NONE;
 }
 
 void *vec_pop_front(Vec *v)
@@ -313,16 +390,19 @@ size_t vec_size(Vec *v)
     return v->len;
 }
 
-int vec_append(Vec *dest, Vec *source)
+Vec_Error vec_append(Vec *dest, Vec *source)
 {
+    RET_IF_NULL_VEC(dest);
+    RET_IF_NULL_VEC(source);
     if (dest->elem_size != source->elem_size)
-        return 1;
-    for (size_t i = 0; i < source->capacity; i++)
+        return UNKNOWN;
+    if (dest->len + source->len > dest->capacity)
     {
-        void *data = vec_at_s(source, i);
-        if (!data)
-            return 2;
-        vec_push_back(dest, data);
+        Vec_Error err = vec_resize(dest, dest->len + source->len);
+        if (V_IS_ERR(err))
+            return err;
     }
-    return 0;
+    memcpy(vec_at(dest, dest->len), source->data, source->len * source->elem_size);
+    dest->len += source->len;
+    return NONE;
 }
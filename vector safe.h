@@ -2,6 +2,10 @@
 #define VECTOR_H_
 
 #include <stdint.h>
+#include <stddef.h>
+#ifdef VEC_ENABLE_BUDGET
+#include "vector budget.h"
+#endif
 
 /*
     INFO:
@@ -43,6 +47,9 @@ struct Vec
     vec_growth_rate_func grow;
     void (*free_entry)(const void *);
     size_t fe_idx; // use by VEC_FOR_EACH to ensure index after altering the vector
+#ifdef VEC_ENABLE_BUDGET
+    VecBudget *budget; // group charged besides the global budget, change it with vec_set_budget
+#endif
 };
 
 #define VEC(type) (vec_new(VECTOR_DEFAULT_CAP, sizeof(type), NULL, NULL, NULL))
@@ -116,7 +123,13 @@ Vec *vec_copy(Vec *v);
 size_t vec_size(Vec *v);
 /*
     Can return NONE, NULL_VEC, NULL_ARG, FAILED_ALLOC,
+    UNKNOWN (elem_size mismatch)
 */
 Vec_Error vec_append(Vec *dest, Vec *source);
+#ifdef VEC_ENABLE_BUDGET
+/* moves the vector and its current allocation to another budget group, NULL for the global budget only.
+    Allocations over a hard limit return FAILED_ALLOC and leave the vector untouched. */
+Vec_Error vec_set_budget(Vec *v, VecBudget *budget);
+#endif
 
 #endif /* VECTOR_H */
\ No newline at end of file
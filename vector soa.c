@@ -0,0 +1,206 @@
+#include "vector soa.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+VecSoA *vec_soa_new(size_t capacity, size_t ncols, const size_t *elem_sizes, const void_cmp_func *cmps)
+{
+    VEC_ASSERT(ncols != 0 && elem_sizes);
+    VecSoA *soa = malloc(sizeof(VecSoA));
+    VEC_ASSERT(soa);
+    *soa = (VecSoA){.cols = malloc(ncols * sizeof(Vec *)), .ncols = ncols, .len = 0};
+    VEC_ASSERT(soa->cols);
+    size_t i;
+    for (i = 0; i < ncols; i++)
+        soa->cols[i] = vec_new(capacity, elem_sizes[i], cmps ? cmps[i] : NULL, NULL, NULL);
+    return soa;
+}
+
+void vec_soa_free(VecSoA *soa)
+{
+    VALIDATE_VECTOR(soa);
+    size_t i;
+    for (i = 0; i < soa->ncols; i++)
+        vec_free(soa->cols[i]);
+    free(soa->cols);
+    free(soa);
+}
+
+Vec *vec_soa_column(VecSoA *soa, size_t col)
+{
+    VALIDATE_VECTOR(soa);
+    if (col >= soa->ncols)
+        return NULL;
+    return soa->cols[col];
+}
+
+void *vec_soa_at(VecSoA *soa, size_t col, size_t idx)
+{
+    VALIDATE_VECTOR(soa);
+    if (col >= soa->ncols || idx >= soa->len)
+        return NULL;
+    return vec_at(soa->cols[col], idx);
+}
+
+void vec_soa_reserve(VecSoA *soa, size_t min_cap)
+{
+    VALIDATE_VECTOR(soa);
+    size_t i;
+    for (i = 0; i < soa->ncols; i++)
+        vec_reserve(soa->cols[i], min_cap);
+}
+
+/* a row is only added when every column has a value, so the columns never disagree on len */
+static int soa_fields_valid(VecSoA *soa, const void *const *fields)
+{
+    size_t i;
+    if (!fields)
+        return 0;
+    for (i = 0; i < soa->ncols; i++)
+        if (!fields[i])
+            return 0;
+    return 1;
+}
+
+int vec_soa_push_back(VecSoA *soa, const void *const *fields)
+{
+    VALIDATE_VECTOR(soa);
+    if (!soa_fields_valid(soa, fields))
+        return 1;
+    size_t i;
+    for (i = 0; i < soa->ncols; i++)
+        vec_push_back(soa->cols[i], (void *)fields[i]);
+    soa->len++;
+    return 0;
+}
+
+int vec_soa_insert(VecSoA *soa, size_t idx, const void *const *fields)
+{
+    VALIDATE_VECTOR(soa);
+    if (idx > soa->len || !soa_fields_valid(soa, fields))
+        return 1;
+    size_t i;
+    for (i = 0; i < soa->ncols; i++)
+        vec_insert(soa->cols[i], idx, (void *)fields[i]);
+    soa->len++;
+    return 0;
+}
+
+void vec_soa_remove(VecSoA *soa, size_t idx)
+{
+    VALIDATE_VECTOR(soa);
+    if (idx >= soa->len)
+        return;
+    size_t i;
+    for (i = 0; i < soa->ncols; i++)
+        vec_remove(soa->cols[i], idx);
+    soa->len--;
+}
+
+void vec_soa_remove_fast(VecSoA *soa, size_t idx)
+{
+    VALIDATE_VECTOR(soa);
+    if (idx >= soa->len)
+        return;
+    size_t i;
+    for (i = 0; i < soa->ncols; i++)
+        vec_remove_fast(soa->cols[i], idx);
+    soa->len--;
+}
+
+int vec_soa_swap(VecSoA *soa, size_t idx0, size_t idx1)
+{
+    VALIDATE_VECTOR(soa);
+    if (idx0 >= soa->len || idx1 >= soa->len)
+        return 1;
+    size_t i;
+    for (i = 0; i < soa->ncols; i++)
+        vec_swap(soa->cols[i], idx0, idx1);
+    return 0;
+}
+
+void vec_soa_clear(VecSoA *soa)
+{
+    VALIDATE_VECTOR(soa);
+    size_t i;
+    for (i = 0; i < soa->ncols; i++)
+        vec_clear(soa->cols[i]);
+    soa->len = 0;
+}
+
+/* bottom up merge sort of pointers into the key column, equal keys keep their order */
+static void soa_merge_sort(byte **ptrs, byte **tmp, size_t n, void_cmp_func cmp)
+{
+    size_t width, lo;
+    byte **src = ptrs, **dst = tmp;
+    for (width = 1; width < n; width *= 2)
+    {
+        for (lo = 0; lo < n; lo += 2 * width)
+        {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t a = lo, b = mid, k = lo;
+            while (a < mid && b < hi)
+                dst[k++] = cmp(src[b], src[a]) < 0 ? src[b++] : src[a++];
+            while (a < mid)
+                dst[k++] = src[a++];
+            while (b < hi)
+                dst[k++] = src[b++];
+        }
+        byte **swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != ptrs)
+        memcpy(ptrs, src, n * sizeof(byte *));
+}
+
+int vec_soa_sort_by(VecSoA *soa, size_t col)
+{
+    VALIDATE_VECTOR(soa);
+    if (col >= soa->ncols)
+        return 1;
+    Vec *key = soa->cols[col];
+    if (!key->cmp)
+    {
+        perror("vec_soa_sort_by: Compare function is undefined.");
+        return 1;
+    }
+    size_t n = soa->len;
+    if (n < 2)
+        return 0;
+
+    size_t i, j, max_bytes = 0;
+    for (i = 0; i < soa->ncols; i++)
+        if (soa->cols[i]->elem_size > max_bytes)
+            max_bytes = soa->cols[i]->elem_size;
+    max_bytes *= n;
+
+    byte **ptrs = malloc(2 * n * sizeof(byte *));
+    byte *gather = malloc(max_bytes);
+    if (!ptrs || !gather)
+    {
+        free(ptrs);
+        free(gather);
+        return 1;
+    }
+    for (i = 0; i < n; i++)
+        ptrs[i] = key->data + i * key->elem_size;
+    soa_merge_sort(ptrs, ptrs + n, n, key->cmp);
+
+    /* turn the sorted pointers into source row indices, then gather every column through them */
+    size_t *perm = (size_t *)(ptrs + n);
+    for (i = 0; i < n; i++)
+        perm[i] = (size_t)(ptrs[i] - key->data) / key->elem_size;
+    for (i = 0; i < soa->ncols; i++)
+    {
+        Vec *c = soa->cols[i];
+        size_t es = c->elem_size;
+        for (j = 0; j < n; j++)
+            memcpy(gather + j * es, c->data + perm[j] * es, es);
+        memcpy(c->data, gather, n * es);
+    }
+    free(ptrs);
+    free(gather);
+    return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file vector soa.h
+ * @brief Structure of arrays built from one Vec per field, kept in lockstep under a shared length.
+ *
+ * @details Loops that read one or two fields of a record only pull those columns through the cache.
+ * Each column is an ordinary Vec with its own elem_size and cmp, so vec_soa_column can be handed to
+ * vec_find, vec_find_idx, vec_at and the V_FOR_EACH macros directly.
+ * Link vector soa.c and vector.c.
+ */
+
+#ifndef VECTOR_SOA_H_
+#define VECTOR_SOA_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "vector.h"
+
+    typedef struct VecSoA
+    {
+        Vec **cols;
+        size_t ncols;
+        size_t len; /* length of every column */
+    } VecSoA;
+
+    /**
+     * @brief Creates a structure of arrays with ncols columns.
+     *
+     * @param capacity Initial capacity of every column.
+     * @param ncols Number of columns, at least 1.
+     * @param elem_sizes Size in bytes of an element of each column.
+     * @param cmps Compare function of each column, may be NULL for none, used by vec_soa_sort_by and vec_find.
+     * @return VecSoA*
+     */
+    VecSoA *vec_soa_new(size_t capacity, size_t ncols, const size_t *elem_sizes, const void_cmp_func *cmps);
+
+    /**
+     * @brief Frees every column and the structure itself.
+     *
+     * @param soa Structure to free.
+     */
+    void vec_soa_free(VecSoA *soa);
+
+    /**
+     * @brief Returns column col as a Vec.
+     *
+     * @param soa Structure to read.
+     * @param col Index of the column.
+     * @return Vec* The column, NULL when col is out of bounds.
+     *
+     * @warning The column may be read, searched or written in place. Adding, removing or reordering elements
+     * through it breaks the lockstep, use the vec_soa functions for that and vec_soa_sort_by to sort.
+     */
+    Vec *vec_soa_column(VecSoA *soa, size_t col);
+
+    /**
+     * @brief Returns a pointer to the field of column col at row idx.
+     *
+     * @param soa Structure to read.
+     * @param col Index of the column.
+     * @param idx Index of the row.
+     * @return void* NULL when either index is out of bounds.
+     */
+    void *vec_soa_at(VecSoA *soa, size_t col, size_t idx);
+
+    /**
+     * @brief Grows every column to hold at least min_cap rows.
+     *
+     * @param soa Structure to grow.
+     * @param min_cap Required capacity.
+     */
+    void vec_soa_reserve(VecSoA *soa, size_t min_cap);
+
+    /**
+     * @brief Appends a row.
+     *
+     * @param soa Structure to push into.
+     * @param fields ncols pointers, fields[i] is copied into column i.
+     * @return int 0 on success, 1 when fields or any fields[i] is NULL, nothing is added then.
+     */
+    int vec_soa_push_back(VecSoA *soa, const void *const *fields);
+
+    /**
+     * @brief Inserts a row before idx, shifting the later rows of every column.
+     *
+     * @param soa Structure to insert into.
+     * @param idx Row to insert before, len appends.
+     * @param fields ncols pointers, fields[i] is copied into column i.
+     * @return int 0 on success, 1 when idx is past len or a field is NULL, nothing is inserted then.
+     */
+    int vec_soa_insert(VecSoA *soa, size_t idx, const void *const *fields);
+
+    /**
+     * @brief Removes the row at idx keeping the order of the rest.
+     *
+     * @param soa Structure to remove from.
+     * @param idx Row to remove.
+     */
+    void vec_soa_remove(VecSoA *soa, size_t idx);
+
+    /**
+     * @brief Removes the row at idx by moving the last row into its place.
+     *
+     * @param soa Structure to remove from.
+     * @param idx Row to remove.
+     */
+    void vec_soa_remove_fast(VecSoA *soa, size_t idx);
+
+    /**
+     * @brief Swaps two rows in every column.
+     *
+     * @param soa Structure to modify.
+     * @param idx0 First row.
+     * @param idx1 Second row.
+     * @return int 0 on success, 1 when either index is out of bounds.
+     */
+    int vec_soa_swap(VecSoA *soa, size_t idx0, size_t idx1);
+
+    /**
+     * @brief Removes every row, calling each column's free_entry.
+     *
+     * @param soa Structure to clear.
+     */
+    void vec_soa_clear(VecSoA *soa);
+
+    /**
+     * @brief Stable sorts the rows by the values of column col using that column's cmp.
+     *
+     * @param soa Structure to sort.
+     * @param col Column to order by.
+     * @return int 0 on success, 1 when col is out of bounds or has no cmp.
+     *
+     * @details Sorts pointers into the key column, then gathers each column through the resulting permutation,
+     * so the other columns are read once each instead of being swapped around during the sort.
+     */
+    int vec_soa_sort_by(VecSoA *soa, size_t col);
+
+#ifdef __cplusplus
+} /* Extern "C" */
+#endif
+
+#endif /* VECTOR_SOA_H_ */
@@ -1,16 +1,376 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* mremap and MADV_HUGEPAGE */
+#endif
+
 #include "vector.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+#if defined(_WIN32)
+#include <malloc.h> /* _aligned_realloc */
+#endif
+
+#if defined(__linux__) && !defined(VEC_DISABLE_MMAP)
+#include <sys/mman.h>
+#include <unistd.h>
+#define VEC_USE_MMAP
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VEC_HAVE_SSE2
+#endif
+
+#if !defined(VEC_DISABLE_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#include <pthread.h>
+#include <unistd.h>
+#define VEC_USE_THREADS
+#endif
+
 void vec_deref_free(const void *data)
 {
     free(*(void **)data);
 }
 
+void vec_deref_free_range(void *first, size_t count, size_t elem_size)
+{
+    byte *p = first;
+    size_t i;
+    for (i = 0; i < count; i++, p += elem_size)
+        free(*(void **)p);
+}
+
+/* hands count entries from first to the destructor, one call for free_range or one per entry for free_entry */
+static void vec_release(Vec *v, size_t first, size_t count)
+{
+    if (!count)
+        return;
+    if (v->free_range)
+    {
+        v->free_range(v->data + first * v->elem_size, count, v->elem_size);
+    }
+    else if (v->free_entry)
+    {
+        size_t i;
+        for (i = first; i < first + count; i++)
+            v->free_entry(v->data + i * v->elem_size);
+    }
+}
+
+#ifdef VEC_ENABLE_STATS
+static VecStats vec_global_stats;
+
+#define VEC_STAT(v, field, n) ((v)->stats.field += (n), vec_global_stats.field += (n))
+
+static void vec_stat_peak(Vec *v)
+{
+    size_t bytes = v->capacity * v->elem_size;
+    if (v->capacity > v->stats.peak_capacity)
+        v->stats.peak_capacity = v->capacity;
+    if (bytes > v->stats.peak_bytes)
+        v->stats.peak_bytes = bytes;
+    if (v->capacity > vec_global_stats.peak_capacity)
+        vec_global_stats.peak_capacity = v->capacity;
+    if (bytes > vec_global_stats.peak_bytes)
+        vec_global_stats.peak_bytes = bytes;
+}
+
+static void vec_stats_print(FILE *out, const char *name, const VecStats *s)
+{
+    fprintf(out, "%s:\n", name);
+    fprintf(out, "\treallocs:      %zu\n", s->reallocs);
+    fprintf(out, "\tbytes moved:   %zu\n", s->bytes_moved);
+    fprintf(out, "\tbytes copied:  %zu\n", s->bytes_copied);
+    fprintf(out, "\tpeak capacity: %zu\n", s->peak_capacity);
+    fprintf(out, "\tpeak bytes:    %zu\n", s->peak_bytes);
+    fprintf(out, "\tfind cmps:     %zu\n", s->find_cmps);
+    fprintf(out, "\tsorts:         %zu\n", s->sorts);
+}
+
+const VecStats *vec_stats_global(void)
+{
+    return &vec_global_stats;
+}
+
+void vec_stats_reset(void)
+{
+    memset(&vec_global_stats, 0, sizeof(vec_global_stats));
+}
+
+void vec_stats_dump(FILE *out)
+{
+    vec_stats_print(out, "vec stats (all vectors)", &vec_global_stats);
+}
+
+void vec_stats_dump_vec(FILE *out, Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    vec_stats_print(out, "vec stats", &v->stats);
+}
+#else
+#define VEC_STAT(v, field, n) ((void)(v))
+#define vec_stat_peak(v) ((void)0)
+#endif
+
+static vec_trace_func vec_global_trace = NULL;
+static size_t vec_trace_memmove_threshold = VEC_TRACE_MEMMOVE_THRESHOLD;
+static FILE *vec_trace_file = NULL;
+
+void vec_trace_set_global(vec_trace_func hook)
+{
+    vec_global_trace = hook;
+}
+
+void vec_trace_set_memmove_threshold(size_t bytes)
+{
+    vec_trace_memmove_threshold = bytes;
+}
+
+static void vec_trace(Vec *v, VecEvent event, size_t old_cap, size_t new_cap, size_t bytes)
+{
+    vec_trace_func hook = v->trace ? v->trace : vec_global_trace;
+    if (hook)
+        hook(v, event, old_cap, new_cap, bytes, v->trace_tag);
+}
+
+/*
+    Trace file layout, little endian:
+        header: "VECTRACE" u32 version
+        record: u8 event, u8 reserved, u16 tag length, u32 elem_size, u64 old_cap, u64 new_cap, u64 bytes, tag bytes
+*/
+#define VEC_TRACE_VERSION 1u
+
+static void vec_trace_put(byte *dest, uint64_t value, size_t len)
+{
+    size_t i;
+    for (i = 0; i < len; i++)
+        dest[i] = (byte)(value >> (8 * i));
+}
+
+int vec_trace_file_open(const char *path)
+{
+    byte header[12];
+    vec_trace_file_close();
+    vec_trace_file = fopen(path, "wb");
+    if (!vec_trace_file)
+        return 1;
+    memcpy(header, "VECTRACE", 8);
+    vec_trace_put(header + 8, VEC_TRACE_VERSION, 4);
+    fwrite(header, 1, sizeof(header), vec_trace_file);
+    vec_global_trace = vec_trace_file_hook;
+    return 0;
+}
+
+void vec_trace_file_close(void)
+{
+    if (vec_global_trace == vec_trace_file_hook)
+        vec_global_trace = NULL;
+    if (vec_trace_file)
+        fclose(vec_trace_file);
+    vec_trace_file = NULL;
+}
+
+void vec_trace_file_hook(Vec *v, VecEvent event, size_t old_cap, size_t new_cap, size_t bytes, const char *tag)
+{
+    byte record[32];
+    size_t tag_len = tag ? strlen(tag) : 0;
+    if (!vec_trace_file)
+        return;
+    if (tag_len > UINT16_MAX)
+        tag_len = UINT16_MAX;
+    record[0] = (byte)event;
+    record[1] = 0;
+    vec_trace_put(record + 2, tag_len, 2);
+    vec_trace_put(record + 4, v->elem_size, 4);
+    vec_trace_put(record + 8, old_cap, 8);
+    vec_trace_put(record + 16, new_cap, 8);
+    vec_trace_put(record + 24, bytes, 8);
+    fwrite(record, 1, sizeof(record), vec_trace_file);
+    if (tag_len)
+        fwrite(tag, 1, tag_len, vec_trace_file);
+}
+
+/* memmove of the tail for insertions and removals */
+static void vec_move(Vec *v, void *dest, const void *src, size_t bytes)
+{
+    VEC_STAT(v, bytes_moved, bytes);
+    if (bytes >= vec_trace_memmove_threshold)
+        vec_trace(v, VEC_EVENT_MEMMOVE, v->capacity, v->capacity, bytes);
+    memmove(dest, src, bytes);
+}
+
 static size_t default_growth_rate(Vec *v)
 {
-    return v->capacity * 2;
+    /* a vector created with capacity 0 would otherwise never grow */
+    return v->capacity ? v->capacity * 2 : VECTOR_DEFAULT_CAP;
+}
+
+size_t vec_shrink_hysteresis(Vec *v)
+{
+    if (v->capacity <= VECTOR_DEFAULT_CAP || v->len >= v->capacity / 4)
+        return v->capacity;
+    return v->capacity / 2 > VECTOR_DEFAULT_CAP ? v->capacity / 2 : VECTOR_DEFAULT_CAP;
+}
+
+/* swaps two non overlapping blocks a register at a time, memcpy keeps the word accesses legal when unaligned */
+static void vec_elem_swap(byte *a, byte *b, size_t size)
+{
+#ifdef VEC_HAVE_SSE2
+    while (size >= 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)a);
+        __m128i vb = _mm_loadu_si128((const __m128i *)b);
+        _mm_storeu_si128((__m128i *)a, vb);
+        _mm_storeu_si128((__m128i *)b, va);
+        a += 16;
+        b += 16;
+        size -= 16;
+    }
+#endif
+    while (size >= sizeof(uint64_t))
+    {
+        uint64_t wa, wb;
+        memcpy(&wa, a, sizeof(wa));
+        memcpy(&wb, b, sizeof(wb));
+        memcpy(a, &wb, sizeof(wb));
+        memcpy(b, &wa, sizeof(wa));
+        a += sizeof(uint64_t);
+        b += sizeof(uint64_t);
+        size -= sizeof(uint64_t);
+    }
+    while (size)
+    {
+        size--;
+        byte tmp = a[size];
+        a[size] = b[size];
+        b[size] = tmp;
+    }
+}
+
+#ifndef VEC_HAVE_SSE2
+static uint64_t vec_bswap64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(x);
+#else
+    x = ((x & 0x00FF00FF00FF00FFull) << 8) | ((x >> 8) & 0x00FF00FF00FF00FFull);
+    x = ((x & 0x0000FFFF0000FFFFull) << 16) | ((x >> 16) & 0x0000FFFF0000FFFFull);
+    return (x << 32) | (x >> 32);
+#endif
+}
+#else
+/* reverses the order of the es byte lanes of a 16 byte register, es is a literal at every call so the switch folds away */
+static __m128i vec_reverse_lanes(__m128i x, size_t es)
+{
+    switch (es)
+    {
+    case 1:
+        x = _mm_shuffle_epi32(x, 0x1B);
+        x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+        return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    case 2:
+        x = _mm_shuffle_epi32(x, 0x1B);
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+    case 4:
+        return _mm_shuffle_epi32(x, 0x1B);
+    case 8:
+        return _mm_shuffle_epi32(x, 0x4E);
+    default:
+        return x;
+    }
+}
+#endif
+
+/* reverses count elements of es bytes, 1/2/4/8/16 byte elements are done 32 bytes per step from both ends */
+static void vec_reverse_block(byte *base, size_t count, size_t es)
+{
+    byte *lo = base, *hi = base + count * es;
+#ifdef VEC_HAVE_SSE2
+    if (es == 1 || es == 2 || es == 4 || es == 8 || es == 16)
+    {
+        while (hi - lo >= 32)
+        {
+            hi -= 16;
+            __m128i vl = _mm_loadu_si128((const __m128i *)lo);
+            __m128i vh = _mm_loadu_si128((const __m128i *)hi);
+            switch (es)
+            {
+            case 1:
+                vl = vec_reverse_lanes(vl, 1);
+                vh = vec_reverse_lanes(vh, 1);
+                break;
+            case 2:
+                vl = vec_reverse_lanes(vl, 2);
+                vh = vec_reverse_lanes(vh, 2);
+                break;
+            case 4:
+                vl = vec_reverse_lanes(vl, 4);
+                vh = vec_reverse_lanes(vh, 4);
+                break;
+            case 8:
+                vl = vec_reverse_lanes(vl, 8);
+                vh = vec_reverse_lanes(vh, 8);
+                break;
+            }
+            _mm_storeu_si128((__m128i *)lo, vh);
+            _mm_storeu_si128((__m128i *)hi, vl);
+            lo += 16;
+        }
+    }
+#else
+    if (es == 1)
+    {
+        while (hi - lo >= 16)
+        {
+            uint64_t wl, wh;
+            hi -= 8;
+            memcpy(&wl, lo, 8);
+            memcpy(&wh, hi, 8);
+            wl = vec_bswap64(wl);
+            wh = vec_bswap64(wh);
+            memcpy(lo, &wh, 8);
+            memcpy(hi, &wl, 8);
+            lo += 8;
+        }
+    }
+#endif
+    /* the middle that is left is still in order, swap it an element at a time */
+    switch (es)
+    {
+    case 1:
+        while (hi - lo > 1)
+        {
+            hi--;
+            byte tmp = *lo;
+            *lo = *hi;
+            *hi = tmp;
+            lo++;
+        }
+        break;
+    case 2:
+    case 4:
+    case 8:
+        while (hi - lo > (ptrdiff_t)es)
+        {
+            uint64_t tl = 0, th = 0;
+            hi -= es;
+            memcpy(&tl, lo, es);
+            memcpy(&th, hi, es);
+            memcpy(lo, &th, es);
+            memcpy(hi, &tl, es);
+            lo += es;
+        }
+        break;
+    default:
+        while (hi - lo > (ptrdiff_t)es)
+        {
+            hi -= es;
+            vec_elem_swap(lo, hi, es);
+            lo += es;
+        }
+        break;
+    }
 }
 
 int vec_char_cmp(const void *data0, const void *data1)
@@ -52,142 +412,1300 @@ int vec_uint_cmp(const void *data0, const void *data1)
     return -1;
 }
 
-int vec_ll_cmp(const void *data0, const void *data1)
+int vec_ll_cmp(const void *data0, const void *data1)
+{
+    /* compare the first byte */
+    if (!(data0 && data1))
+        return 0;
+    long long d0 = *(long long *)data0, d1 = *(long long *)data1;
+    if (d0 == d1)
+        return 0;
+    if (d0 > d1)
+        return 1;
+    return -1;
+}
+
+int vec_ull_cmp(const void *data0, const void *data1)
+{
+    /* compare the first byte */
+    if (!(data0 && data1))
+        return 0;
+    unsigned long long d0 = *(unsigned long long *)data0, d1 = *(unsigned long long *)data1;
+    if (d0 == d1)
+        return 0;
+    if (d0 > d1)
+        return 1;
+    return -1;
+}
+
+/*
+    Bulk copies for vec_copy, vec_arr_copy, vec_append and storage moves.
+    Below VEC_STREAM_THRESHOLD bytes this is memcpy. Above it the destination is written with non temporal stores
+    that go around the cache, and above VEC_COPY_THREAD_BYTES the copy is split between threads
+    since a single core cannot use all of the memory bandwidth.
+*/
+
+static void vec_stream_copy(byte *dst, const byte *src, size_t bytes)
+{
+#ifdef VEC_HAVE_SSE2
+    size_t head = (16 - ((uintptr_t)dst & 15)) & 15, i;
+    if (head > bytes)
+        head = bytes;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    bytes -= head;
+    for (i = 0; i + 64 <= bytes; i += 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + i + 32));
+        __m128i d = _mm_loadu_si128((const __m128i *)(src + i + 48));
+        _mm_stream_si128((__m128i *)(dst + i), a);
+        _mm_stream_si128((__m128i *)(dst + i + 16), b);
+        _mm_stream_si128((__m128i *)(dst + i + 32), c);
+        _mm_stream_si128((__m128i *)(dst + i + 48), d);
+    }
+    for (; i + 16 <= bytes; i += 16)
+        _mm_stream_si128((__m128i *)(dst + i), _mm_loadu_si128((const __m128i *)(src + i)));
+    memcpy(dst + i, src + i, bytes - i);
+    /* streaming stores are weakly ordered, make them visible before the thread reports back */
+    _mm_sfence();
+#else
+    memcpy(dst, src, bytes);
+#endif
+}
+
+#ifdef VEC_USE_THREADS
+typedef struct VecCopyPart
+{
+    byte *dst;
+    const byte *src;
+    size_t bytes;
+} VecCopyPart;
+
+static void *vec_copy_part(void *arg)
+{
+    VecCopyPart *p = arg;
+    vec_stream_copy(p->dst, p->src, p->bytes);
+    return NULL;
+}
+#endif
+
+/* copies bytes between non overlapping blocks */
+static void vec_bulk_copy(void *dst, const void *src, size_t bytes)
+{
+    if (bytes < VEC_STREAM_THRESHOLD)
+    {
+        memcpy(dst, src, bytes);
+        return;
+    }
+#ifdef VEC_USE_THREADS
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (bytes >= VEC_COPY_THREAD_BYTES && cpus > 1)
+    {
+        size_t parts = cpus < VEC_COPY_MAX_THREADS ? (size_t)cpus : VEC_COPY_MAX_THREADS, i;
+        /* whole cache lines per part, the calling thread copies the first and any part whose thread fails to start */
+        size_t chunk = ((bytes + parts - 1) / parts + VEC_CACHE_LINE - 1) / VEC_CACHE_LINE * VEC_CACHE_LINE;
+        VecCopyPart p[VEC_COPY_MAX_THREADS];
+        pthread_t threads[VEC_COPY_MAX_THREADS];
+        int started[VEC_COPY_MAX_THREADS];
+        for (i = 0; i < parts; i++)
+        {
+            size_t begin = i * chunk < bytes ? i * chunk : bytes, end = (i + 1) * chunk < bytes ? (i + 1) * chunk : bytes;
+            p[i] = (VecCopyPart){.dst = (byte *)dst + begin, .src = (const byte *)src + begin, .bytes = end - begin};
+        }
+        for (i = 1; i < parts; i++)
+            started[i] = pthread_create(&threads[i], NULL, vec_copy_part, &p[i]) == 0;
+        vec_copy_part(&p[0]);
+        for (i = 1; i < parts; i++)
+        {
+            if (started[i])
+                pthread_join(threads[i], NULL);
+            else
+                vec_copy_part(&p[i]);
+        }
+        return;
+    }
+#endif
+    vec_stream_copy(dst, src, bytes);
+}
+
+/*
+    Storage of v->data. Three kinds depending on the vector:
+        plain realloc when v->align is 0,
+        aligned blocks (_aligned_realloc, or posix_memalign and a copy) otherwise,
+        an mmap mapping grown with mremap once it reaches VEC_MMAP_THRESHOLD bytes (VEC_FLAG_MMAP).
+*/
+
+#ifdef VEC_USE_MMAP
+static size_t vec_map_len(size_t bytes)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (bytes + page - 1) / page * page;
+}
+
+static byte *vec_map_resize(Vec *v, size_t old_bytes, size_t new_bytes)
+{
+    void *p = mremap(v->data, vec_map_len(old_bytes), vec_map_len(new_bytes), MREMAP_MAYMOVE);
+    if (p == MAP_FAILED)
+        return NULL;
+#ifdef MADV_HUGEPAGE
+    madvise(p, vec_map_len(new_bytes), MADV_HUGEPAGE);
+#endif
+    return (byte *)p;
+}
+
+static byte *vec_map_new(size_t bytes)
+{
+    void *p = mmap(NULL, vec_map_len(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+#ifdef MADV_HUGEPAGE
+    madvise(p, vec_map_len(bytes), MADV_HUGEPAGE);
+#endif
+    return (byte *)p;
+}
+#endif
+
+static void vec_heap_free(Vec *v, byte *data)
+{
+#if defined(_WIN32)
+    if (v->align)
+    {
+        _aligned_free(data);
+        return;
+    }
+#else
+    (void)v;
+#endif
+    free(data);
+}
+
+static byte *vec_heap_realloc(Vec *v, size_t old_bytes, size_t new_bytes)
+{
+    if (!v->align)
+        return (byte *)realloc(v->data, new_bytes);
+#if defined(_WIN32)
+    (void)old_bytes;
+    return (byte *)_aligned_realloc(v->data, new_bytes, v->align);
+#else
+    void *p;
+    if (posix_memalign(&p, v->align, new_bytes))
+        return NULL;
+    if (v->data)
+        vec_bulk_copy(p, v->data, old_bytes < new_bytes ? old_bytes : new_bytes);
+    free(v->data);
+    return (byte *)p;
+#endif
+}
+
+/* size of the current allocation, vec_clamp keeps one element for an empty vector */
+static size_t vec_storage_bytes(Vec *v)
+{
+    return (v->capacity ? v->capacity : 1) * v->elem_size * sizeof(byte);
+}
+
+static byte *vec_storage_realloc_raw(Vec *v, size_t old_bytes, size_t new_bytes)
+{
+    VEC_STAT(v, reallocs, 1);
+#ifdef VEC_USE_MMAP
+    if (v->flags & VEC_FLAG_MMAP)
+        return vec_map_resize(v, old_bytes, new_bytes);
+    if (new_bytes >= VEC_MMAP_THRESHOLD && v->align <= (size_t)sysconf(_SC_PAGESIZE))
+    {
+        byte *p = vec_map_new(new_bytes);
+        if (!p)
+            return vec_heap_realloc(v, old_bytes, new_bytes);
+        if (v->data)
+            vec_bulk_copy(p, v->data, old_bytes < new_bytes ? old_bytes : new_bytes);
+        vec_heap_free(v, v->data);
+        v->flags |= VEC_FLAG_MMAP;
+        return p;
+    }
+#endif
+    return vec_heap_realloc(v, old_bytes, new_bytes);
+}
+
+/* returns the resized data or NULL, in which case v->data is untouched */
+static byte *vec_storage_realloc(Vec *v, size_t new_bytes)
+{
+    size_t old_bytes = v->data ? vec_storage_bytes(v) : 0;
+#ifdef VEC_ENABLE_BUDGET
+    if (vec_budget_charge(v->budget, old_bytes, new_bytes))
+        return NULL;
+    byte *p = vec_storage_realloc_raw(v, old_bytes, new_bytes);
+    if (!p)
+        vec_budget_charge(v->budget, new_bytes, old_bytes);
+    return p;
+#else
+    return vec_storage_realloc_raw(v, old_bytes, new_bytes);
+#endif
+}
+
+static void vec_storage_free(Vec *v)
+{
+#ifdef VEC_ENABLE_BUDGET
+    if (v->data)
+        vec_budget_charge(v->budget, vec_storage_bytes(v), 0);
+#endif
+#ifdef VEC_USE_MMAP
+    if (v->flags & VEC_FLAG_MMAP)
+    {
+        munmap(v->data, vec_map_len(vec_storage_bytes(v)));
+        v->flags &= ~VEC_FLAG_MMAP;
+        v->data = NULL;
+        return;
+    }
+#endif
+    vec_heap_free(v, v->data);
+    v->data = NULL;
+}
+
+#ifdef VEC_ENABLE_BUDGET
+void vec_set_budget(Vec *v, VecBudget *budget)
+{
+    VALIDATE_VECTOR(v);
+    if (v->data)
+        vec_budget_move(v->budget, budget, vec_storage_bytes(v));
+    v->budget = budget;
+}
+#endif
+
+Vec *vec_new(size_t capacity, size_t elem_size, void_cmp_func cmp, vec_growth_rate_func grow, void (*free_entry)(const void *))
+{
+    return vec_new_aligned(capacity, elem_size, 0, cmp, grow, free_entry);
+}
+
+Vec *vec_new_aligned(size_t capacity, size_t elem_size, size_t align, void_cmp_func cmp, vec_growth_rate_func grow, void (*free_entry)(const void *))
+{
+    VEC_ASSERT(elem_size != 0);
+    VEC_ASSERT((align & (align - 1)) == 0 && "vec_new_aligned: Alignment must be a power of two.");
+    Vec *p = malloc(sizeof(Vec));
+    VEC_ASSERT(p);
+    /* posix_memalign wants at least pointer alignment */
+    if (align && align < sizeof(void *))
+        align = sizeof(void *);
+    *p = (Vec){.elem_size = elem_size,
+               .capacity = 0,
+               .len = 0,
+               .data = NULL,
+               .cmp = cmp ? cmp : NULL,
+               .grow = grow ? grow : default_growth_rate,
+               .free_entry = free_entry ? free_entry : NULL,
+               .align = align,};
+    vec_resize(p, capacity);
+    return p;
+}
+
+void vec_free(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    /* no vec_clear, its shrink and memset would only touch storage that is about to go */
+    vec_release(v, 0, v->len);
+    vec_storage_free(v);
+    free(v->scratch);
+    free(v);
+}
+
+void *vec_at(Vec *v, size_t index)
+{
+    return (void *)(&v->data[index * v->elem_size]);
+}
+
+void *vec_at_s(Vec *v, size_t index)
+{
+    VALIDATE_VECTOR(v);
+    if (index >= v->len)
+    {
+        return NULL;
+    }
+    return vec_at(v, index);
+}
+
+static void vec_resize_impl(Vec *v, size_t new_cap, int zero)
+{
+    if (new_cap == v->capacity)
+        return;
+    if (!new_cap)
+        new_cap++;
+    /* entries that no longer fit are dropped like vec_clear drops them */
+    if (new_cap < v->len)
+    {
+        vec_release(v, new_cap, v->len - new_cap);
+        v->len = new_cap;
+    }
+    byte *new_data = vec_storage_realloc(v, new_cap * v->elem_size * sizeof(byte));
+    VEC_ASSERT(new_data != NULL && "vec_resize: Failed to resize vec array or over the hard memory limit.");
+
+    /*  Initialize the newly allocated memory */
+    if (zero && v->capacity < new_cap)
+    {
+        size_t old_cap_start = v->capacity * v->elem_size * sizeof(byte);
+        size_t region_len = new_cap - v->capacity;
+        memset(new_data + old_cap_start, 0, region_len * v->elem_size * sizeof(byte));
+    }
+    size_t old_cap = v->capacity;
+    v->capacity = new_cap;
+    v->data = new_data;
+    vec_stat_peak(v);
+    /* the hook sees the vector after the resize */
+    vec_trace(v, new_cap > old_cap ? VEC_EVENT_GROW : VEC_EVENT_SHRINK, old_cap, new_cap, new_cap * v->elem_size);
+}
+
+/* consults v->shrink after a removal, keeps the slot at v->len so a popped element stays readable */
+static void vec_maybe_shrink(Vec *v)
+{
+    if (!v->shrink)
+        return;
+    size_t new_cap = v->shrink(v);
+    if (new_cap <= v->len)
+        new_cap = v->len + 1;
+    if (new_cap < v->capacity)
+        vec_resize(v, new_cap);
+}
+
+void vec_resize(Vec *v, size_t new_cap)
+{
+    VALIDATE_VECTOR(v);
+    vec_resize_impl(v, new_cap, !(v->flags & VEC_FLAG_NO_ZERO));
+}
+
+void vec_resize_uninit(Vec *v, size_t new_cap)
+{
+    VALIDATE_VECTOR(v);
+    vec_resize_impl(v, new_cap, 0);
+}
+
+void *vec_emplace_back(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    if (v->len >= v->capacity)
+        vec_resize(v, v->grow(v));
+    return vec_at(v, v->len++);
+}
+
+void vec_push_back(Vec *v, void *data)
+{
+    VALIDATE_VECTOR(v);
+    if (!data)
+        return;
+    if (v->len >= v->capacity)
+        vec_resize(v, v->grow(v));
+    VEC_STAT(v, bytes_copied, v->elem_size);
+    memcpy(vec_at(v, v->len), data, v->elem_size * sizeof(byte));
+    v->len++;
+}
+
+void vec_sort(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    if (!v->cmp)
+    {
+        perror("vec_sort: Compare function is undefined.");
+        return;
+    }
+    VEC_STAT(v, sorts, 1);
+    qsort(v->data, v->len, v->elem_size, v->cmp);
+}
+
+/* Stable sort: timsort style run detection and merging, without galloping inside the merge loops. */
+
+typedef struct
+{
+    byte *base;
+    size_t elem_size;
+    void_cmp_func cmp;
+    byte *tmp; /* holds at least half the array, and one element for the insertion sort pivot */
+    size_t run_start[96];
+    size_t run_len[96];
+    size_t runs;
+} merge_state;
+
+#define MS_AT(ms, i) ((ms)->base + (i) * (ms)->elem_size)
+
+static size_t merge_min_run(size_t n)
+{
+    size_t r = 0;
+    while (n >= 64)
+    {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+/* length of the run starting at lo, strictly descending runs are reversed in place */
+static size_t merge_count_run(merge_state *ms, size_t lo, size_t hi)
+{
+    size_t k = lo + 1;
+    if (k == hi)
+        return 1;
+    if (ms->cmp(MS_AT(ms, k), MS_AT(ms, lo)) < 0)
+    {
+        size_t a, b;
+        while (k + 1 < hi && ms->cmp(MS_AT(ms, k + 1), MS_AT(ms, k)) < 0)
+            k++;
+        for (a = lo, b = k; a < b; a++, b--)
+            vec_elem_swap(MS_AT(ms, a), MS_AT(ms, b), ms->elem_size);
+    }
+    else
+    {
+        while (k + 1 < hi && ms->cmp(MS_AT(ms, k + 1), MS_AT(ms, k)) >= 0)
+            k++;
+    }
+    return k + 1 - lo;
+}
+
+/* sorts [lo, hi) knowing [lo, start) is already sorted */
+static void merge_insertion_sort(merge_state *ms, size_t lo, size_t hi, size_t start)
+{
+    size_t es = ms->elem_size;
+    for (; start < hi; start++)
+    {
+        size_t left = lo, right = start;
+        memcpy(ms->tmp, MS_AT(ms, start), es);
+        while (left < right)
+        {
+            size_t mid = left + (right - left) / 2;
+            if (ms->cmp(ms->tmp, MS_AT(ms, mid)) < 0)
+                right = mid;
+            else
+                left = mid + 1;
+        }
+        memmove(MS_AT(ms, left + 1), MS_AT(ms, left), (start - left) * es);
+        memcpy(MS_AT(ms, left), ms->tmp, es);
+    }
+}
+
+/* first index in [lo, hi) whose element is greater than key (upper) or not less than key (lower) */
+static size_t merge_bound(merge_state *ms, size_t lo, size_t hi, const byte *key, int upper)
+{
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        int c = ms->cmp(MS_AT(ms, mid), key);
+        if (upper ? c <= 0 : c < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* merges the adjacent runs [a, a + la) and [a + la, a + la + lb), copying the shorter one aside */
+static void merge_runs(merge_state *ms, size_t a, size_t la, size_t lb)
+{
+    size_t es = ms->elem_size, b = a + la, skip;
+
+    /* elements of A not greater than B[0] and elements of B not less than A[last] are already in place */
+    skip = merge_bound(ms, a, b, MS_AT(ms, b), 1) - a;
+    a += skip;
+    la -= skip;
+    if (!la)
+        return;
+    lb = merge_bound(ms, b, b + lb, MS_AT(ms, b - 1), 0) - b;
+    if (!lb)
+        return;
+
+    if (la <= lb)
+    {
+        byte *dest = MS_AT(ms, a), *pa = ms->tmp, *ea = ms->tmp + la * es, *pb = MS_AT(ms, b), *eb = MS_AT(ms, b + lb);
+        memcpy(ms->tmp, dest, la * es);
+        while (pa < ea && pb < eb)
+        {
+            if (ms->cmp(pb, pa) < 0)
+            {
+                memcpy(dest, pb, es);
+                pb += es;
+            }
+            else
+            {
+                memcpy(dest, pa, es);
+                pa += es;
+            }
+            dest += es;
+        }
+        memcpy(dest, pa, (size_t)(ea - pa));
+    }
+    else
+    {
+        /* merge from the back, A stays in place and B goes to tmp */
+        byte *dest = MS_AT(ms, b + lb), *pa = MS_AT(ms, b), *sa = MS_AT(ms, a), *pb = ms->tmp + lb * es;
+        memcpy(ms->tmp, MS_AT(ms, b), lb * es);
+        while (pa > sa && pb > ms->tmp)
+        {
+            dest -= es;
+            if (ms->cmp(pa - es, pb - es) > 0)
+            {
+                pa -= es;
+                memcpy(dest, pa, es);
+            }
+            else
+            {
+                pb -= es;
+                memcpy(dest, pb, es);
+            }
+        }
+        memcpy(sa, ms->tmp, (size_t)(pb - ms->tmp));
+    }
+}
+
+static void merge_at(merge_state *ms, size_t i)
+{
+    merge_runs(ms, ms->run_start[i], ms->run_len[i], ms->run_len[i + 1]);
+    ms->run_len[i] += ms->run_len[i + 1];
+    if (i + 3 == ms->runs)
+    {
+        ms->run_start[i + 1] = ms->run_start[i + 2];
+        ms->run_len[i + 1] = ms->run_len[i + 2];
+    }
+    ms->runs--;
+}
+
+/* keeps run lengths growing at least like the fibonacci numbers from the top of the stack down */
+static void merge_collapse(merge_state *ms)
+{
+    while (ms->runs > 1)
+    {
+        size_t n = ms->runs - 2, *len = ms->run_len;
+        if ((n > 0 && len[n - 1] <= len[n] + len[n + 1]) || (n > 1 && len[n - 2] <= len[n - 1] + len[n]))
+        {
+            if (len[n - 1] < len[n + 1])
+                n--;
+        }
+        else if (len[n] > len[n + 1])
+        {
+            break;
+        }
+        merge_at(ms, n);
+    }
+}
+
+static void merge_force_collapse(merge_state *ms)
+{
+    while (ms->runs > 1)
+    {
+        size_t n = ms->runs - 2;
+        if (n > 0 && ms->run_len[n - 1] < ms->run_len[n + 1])
+            n--;
+        merge_at(ms, n);
+    }
+}
+
+static void vec_merge_sort(Vec *v, byte *tmp)
+{
+    merge_state ms = {.base = v->data, .elem_size = v->elem_size, .cmp = v->cmp, .tmp = tmp, .runs = 0};
+    size_t lo = 0, n = v->len, min_run = merge_min_run(n);
+    while (lo < n)
+    {
+        size_t run = merge_count_run(&ms, lo, n);
+        if (run < min_run)
+        {
+            size_t force = n - lo < min_run ? n - lo : min_run;
+            merge_insertion_sort(&ms, lo, lo + force, lo + run);
+            run = force;
+        }
+        ms.run_start[ms.runs] = lo;
+        ms.run_len[ms.runs] = run;
+        ms.runs++;
+        merge_collapse(&ms);
+        lo += run;
+    }
+    merge_force_collapse(&ms);
+}
+
+size_t vec_stable_sort_scratch_size(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    return (v->len / 2 ? v->len / 2 : 1) * v->elem_size * sizeof(byte);
+}
+
+int vec_stable_sort_buf(Vec *v, void *scratch, size_t scratch_size)
+{
+    VALIDATE_VECTOR(v);
+    if (!v->cmp)
+    {
+        perror("vec_stable_sort: Compare function is undefined.");
+        return 1;
+    }
+    if (v->len < 2)
+        return 0;
+    if (!scratch || scratch_size < vec_stable_sort_scratch_size(v))
+        return 1;
+    VEC_STAT(v, sorts, 1);
+    vec_merge_sort(v, scratch);
+    return 0;
+}
+
+void vec_stable_sort(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    size_t needed = vec_stable_sort_scratch_size(v);
+    if (v->scratch_size < needed)
+    {
+        byte *tmp = (byte *)realloc(v->scratch, needed);
+        VEC_ASSERT(tmp && "vec_stable_sort: Failed to allocate merge buffer.");
+        v->scratch = tmp;
+        v->scratch_size = needed;
+    }
+    vec_stable_sort_buf(v, v->scratch, v->scratch_size);
+}
+
+void vec_insert(Vec *v, size_t index, void *data)
+{
+    VALIDATE_VECTOR(v);
+    if (index > v->len)
+        return;
+
+    if (v->len >= v->capacity)
+        vec_resize(v, v->grow(v));
+
+    vec_move(v, vec_at(v, index + 1), vec_at(v, index), (v->len - index) * v->elem_size * sizeof(byte));
+    VEC_STAT(v, bytes_copied, v->elem_size);
+    memcpy(vec_at(v, index), data, v->elem_size);
+
+    v->len++;
+}
+
+void vec_reserve(Vec *v, size_t min_cap)
+{
+    VALIDATE_VECTOR(v);
+    if (min_cap <= v->capacity)
+        return;
+    size_t new_cap = v->grow(v);
+    vec_resize(v, new_cap > min_cap ? new_cap : min_cap);
+}
+
+void vec_insert_n(Vec *v, size_t index, const void *src, size_t count)
+{
+    VALIDATE_VECTOR(v);
+    if (index > v->len || !src || !count)
+        return;
+
+    /* src may live inside the buffer that is about to move */
+    size_t bytes = count * v->elem_size * sizeof(byte);
+    byte *tmp = NULL;
+    if ((const byte *)src >= v->data && (const byte *)src < v->data + v->capacity * v->elem_size)
+    {
+        tmp = (byte *)malloc(bytes);
+        VEC_ASSERT(tmp);
+        memcpy(tmp, src, bytes);
+        src = tmp;
+    }
+
+    if (v->len + count > v->capacity)
+        vec_reserve(v, v->len + count);
+
+    vec_move(v, vec_at(v, index + count), vec_at(v, index), (v->len - index) * v->elem_size * sizeof(byte));
+    VEC_STAT(v, bytes_copied, bytes);
+    memcpy(vec_at(v, index), src, bytes);
+    v->len += count;
+    free(tmp);
+}
+
+int vec_insert_vec(Vec *v, size_t index, Vec *other)
+{
+    VALIDATE_VECTOR(v);
+    VALIDATE_VECTOR(other);
+    if (v->elem_size != other->elem_size || index > v->len)
+        return 1;
+    vec_insert_n(v, index, other->data, other->len);
+    return 0;
+}
+
+/* d-ary heap over a raw array, dir is 1 for a max heap by cmp and -1 for a min heap */
+typedef struct
+{
+    byte *base;
+    size_t elem_size;
+    void_cmp_func cmp;
+    size_t arity;
+    int dir;
+} heap_view;
+
+#define HEAP_AT(h, i) ((h)->base + (i) * (h)->elem_size)
+#define HEAP_LESS(h, i, j) ((h)->dir * (h)->cmp(HEAP_AT(h, i), HEAP_AT(h, j)) < 0)
+
+static void heap_sift_up(const heap_view *h, size_t i)
+{
+    while (i > 0)
+    {
+        size_t parent = (i - 1) / h->arity;
+        if (!HEAP_LESS(h, parent, i))
+            break;
+        vec_elem_swap(HEAP_AT(h, parent), HEAP_AT(h, i), h->elem_size);
+        i = parent;
+    }
+}
+
+static void heap_sift_down(const heap_view *h, size_t i, size_t n)
+{
+    for (;;)
+    {
+        size_t first = i * h->arity + 1, largest = i, c;
+        for (c = first; c < first + h->arity && c < n; c++)
+        {
+            if (HEAP_LESS(h, largest, c))
+                largest = c;
+        }
+        if (largest == i)
+            return;
+        vec_elem_swap(HEAP_AT(h, i), HEAP_AT(h, largest), h->elem_size);
+        i = largest;
+    }
+}
+
+static void heap_make(const heap_view *h, size_t n)
+{
+    size_t i;
+    if (n < 2)
+        return;
+    i = (n - 2) / h->arity + 1;
+    while (i--)
+        heap_sift_down(h, i, n);
+}
+
+/* sorts a heap of n elements in place, ascending by h->dir * cmp */
+static void heap_sort_made(const heap_view *h, size_t n)
+{
+    while (n > 1)
+    {
+        n--;
+        vec_elem_swap(HEAP_AT(h, 0), HEAP_AT(h, n), h->elem_size);
+        heap_sift_down(h, 0, n);
+    }
+}
+
+static int vec_heap_view(Vec *v, size_t arity, heap_view *h, const char *err)
+{
+    VALIDATE_VECTOR(v);
+    if (!v->cmp)
+    {
+        perror(err);
+        return 0;
+    }
+    *h = (heap_view){.base = v->data, .elem_size = v->elem_size, .cmp = v->cmp, .arity = arity, .dir = 1};
+    return 1;
+}
+
+static void vec_heap_make_n(Vec *v, size_t arity)
+{
+    heap_view h;
+    if (vec_heap_view(v, arity, &h, "vec_heap_make: Compare function is undefined."))
+        heap_make(&h, v->len);
+}
+
+static void vec_heap_push_n(Vec *v, void *data, size_t arity)
+{
+    heap_view h;
+    if (!data || !vec_heap_view(v, arity, &h, "vec_heap_push: Compare function is undefined."))
+        return;
+    vec_push_back(v, data);
+    h.base = v->data; /* push may have moved the buffer */
+    heap_sift_up(&h, v->len - 1);
+}
+
+static void *vec_heap_pop_n(Vec *v, size_t arity)
+{
+    heap_view h;
+    if (!vec_heap_view(v, arity, &h, "vec_heap_pop: Compare function is undefined.") || v->len < 1)
+        return NULL;
+    v->len--;
+    vec_elem_swap(HEAP_AT(&h, 0), HEAP_AT(&h, v->len), v->elem_size);
+    heap_sift_down(&h, 0, v->len);
+    return vec_at(v, v->len);
+}
+
+static void vec_heap_replace_n(Vec *v, void *data, size_t arity)
+{
+    heap_view h;
+    if (!data || !vec_heap_view(v, arity, &h, "vec_heap_replace: Compare function is undefined."))
+        return;
+    if (!v->len)
+    {
+        vec_heap_push_n(v, data, arity);
+        return;
+    }
+    memcpy(v->data, data, v->elem_size * sizeof(byte));
+    heap_sift_down(&h, 0, v->len);
+}
+
+void vec_heap_make(Vec *v)
+{
+    vec_heap_make_n(v, 2);
+}
+
+void vec_heap_push(Vec *v, void *data)
+{
+    vec_heap_push_n(v, data, 2);
+}
+
+void *vec_heap_pop(Vec *v)
+{
+    return vec_heap_pop_n(v, 2);
+}
+
+void *vec_heap_top(Vec *v)
+{
+    return vec_at_s(v, 0);
+}
+
+void vec_heap_replace(Vec *v, void *data)
+{
+    vec_heap_replace_n(v, data, 2);
+}
+
+void vec_heap4_make(Vec *v)
+{
+    vec_heap_make_n(v, 4);
+}
+
+void vec_heap4_push(Vec *v, void *data)
 {
-    /* compare the first byte */
-    if (!(data0 && data1))
-        return 0;
-    long long d0 = *(long long *)data0, d1 = *(long long *)data1;
-    if (d0 == d1)
-        return 0;
-    if (d0 > d1)
-        return 1;
-    return -1;
+    vec_heap_push_n(v, data, 4);
 }
 
-int vec_ull_cmp(const void *data0, const void *data1)
+void *vec_heap4_pop(Vec *v)
 {
-    /* compare the first byte */
-    if (!(data0 && data1))
-        return 0;
-    unsigned long long d0 = *(unsigned long long *)data0, d1 = *(unsigned long long *)data1;
-    if (d0 == d1)
-        return 0;
-    if (d0 > d1)
-        return 1;
-    return -1;
+    return vec_heap_pop_n(v, 4);
 }
 
-Vec *vec_new(size_t capacity, size_t elem_size, void_cmp_func cmp, vec_growth_rate_func grow, void (*free_entry)(const void *))
+void vec_heap4_replace(Vec *v, void *data)
 {
-    VEC_ASSERT(elem_size != 0);
-    Vec *p = malloc(sizeof(Vec));
-    VEC_ASSERT(p);
-    *p = (Vec){.elem_size = elem_size,
-               .capacity = 0,
-               .len = 0,
-               .data = NULL,
-               .cmp = cmp ? cmp : NULL,
-               .grow = grow ? grow : default_growth_rate,
-               .free_entry = free_entry ? free_entry : NULL,};
-    vec_resize(p, capacity);
-    return p;
+    vec_heap_replace_n(v, data, 4);
 }
 
-void vec_free(Vec *v)
+static void select_insertion_sort(const heap_view *h, size_t lo, size_t hi)
 {
-    VALIDATE_VECTOR(v);
-    vec_clear(v);
-    free(v->data);
-    free(v);
+    size_t i, j;
+    for (i = lo + 1; i < hi; i++)
+    {
+        for (j = i; j > lo && HEAP_LESS(h, j, j - 1); j--)
+            vec_elem_swap(HEAP_AT(h, j), HEAP_AT(h, j - 1), h->elem_size);
+    }
 }
 
-void *vec_at(Vec *v, size_t index)
+/* Hoare partition of [lo, hi) around a median of three, returns the final pivot index */
+static size_t select_partition(const heap_view *h, size_t lo, size_t hi)
 {
-    return (void *)(&v->data[index * v->elem_size]);
+    size_t mid = lo + (hi - lo) / 2, i = lo, j = hi;
+    if (HEAP_LESS(h, mid, lo))
+        vec_elem_swap(HEAP_AT(h, mid), HEAP_AT(h, lo), h->elem_size);
+    if (HEAP_LESS(h, hi - 1, mid))
+    {
+        vec_elem_swap(HEAP_AT(h, hi - 1), HEAP_AT(h, mid), h->elem_size);
+        if (HEAP_LESS(h, mid, lo))
+            vec_elem_swap(HEAP_AT(h, mid), HEAP_AT(h, lo), h->elem_size);
+    }
+    /* pivot goes to lo, a[hi - 1] >= pivot stops the forward scan */
+    vec_elem_swap(HEAP_AT(h, mid), HEAP_AT(h, lo), h->elem_size);
+    for (;;)
+    {
+        do
+            i++;
+        while (HEAP_LESS(h, i, lo));
+        do
+            j--;
+        while (HEAP_LESS(h, lo, j));
+        if (i >= j)
+            break;
+        vec_elem_swap(HEAP_AT(h, i), HEAP_AT(h, j), h->elem_size);
+    }
+    vec_elem_swap(HEAP_AT(h, lo), HEAP_AT(h, j), h->elem_size);
+    return j;
 }
 
-void *vec_at_s(Vec *v, size_t index)
+/* places the k-th element of [lo, hi) with a max heap over [lo, k], used when quickselect degrades */
+static void select_heap(const heap_view *h, size_t lo, size_t hi, size_t k)
 {
-    VALIDATE_VECTOR(v);
-    if (index >= v->len)
+    heap_view sub = *h;
+    size_t i, n = k - lo + 1;
+    sub.base = HEAP_AT(h, lo);
+    heap_make(&sub, n);
+    for (i = n; i < hi - lo; i++)
     {
-        return NULL;
+        if (HEAP_LESS(&sub, i, 0))
+        {
+            vec_elem_swap(HEAP_AT(&sub, i), sub.base, sub.elem_size);
+            heap_sift_down(&sub, 0, n);
+        }
     }
-    return vec_at(v, index);
+    vec_elem_swap(sub.base, HEAP_AT(&sub, n - 1), sub.elem_size);
 }
 
-void vec_resize(Vec *v, size_t new_cap)
+void vec_nth_element(Vec *v, size_t n)
 {
-    VALIDATE_VECTOR(v);
-    if (new_cap == v->capacity)
+    heap_view h;
+    size_t lo = 0, hi, depth = 0;
+    if (!vec_heap_view(v, 2, &h, "vec_nth_element: Compare function is undefined.") || n >= v->len)
         return;
-    if (!new_cap)
-        new_cap++;
-    byte *new_data = (byte *)realloc(v->data, new_cap * v->elem_size * sizeof(byte));
-    VEC_ASSERT(new_data != NULL && "vec_resize: Failed to resize vec array.");
-
-    /*  Initialize the newly allocated memory */
-    size_t old_cap_start = v->capacity * v->elem_size * sizeof(byte);
-    if (old_cap_start < new_cap)
+    VEC_STAT(v, sorts, 1);
+    hi = v->len;
+    for (lo = v->len; lo > 1; lo >>= 1)
+        depth += 2;
+    lo = 0;
+    while (hi - lo > 16)
     {
-        size_t region_len = new_cap - v->capacity;
-        memset(new_data + old_cap_start, 0, region_len * v->elem_size * sizeof(byte));
+        if (!depth--)
+        {
+            select_heap(&h, lo, hi, n);
+            return;
+        }
+        size_t p = select_partition(&h, lo, hi);
+        if (p == n)
+            return;
+        if (n < p)
+            hi = p;
+        else
+            lo = p + 1;
     }
-    v->capacity = new_cap;
-    v->data = new_data;
+    select_insertion_sort(&h, lo, hi);
 }
 
-void vec_push_back(Vec *v, void *data)
+void vec_partial_sort(Vec *v, size_t k)
 {
-    VALIDATE_VECTOR(v);
-    if (!data)
+    heap_view h;
+    size_t i;
+    if (!vec_heap_view(v, 2, &h, "vec_partial_sort: Compare function is undefined."))
         return;
-    if (v->len >= v->capacity)
-        vec_resize(v, v->grow(v));
-    memcpy(vec_at(v, v->len), data, v->elem_size * sizeof(byte));
-    v->len++;
+    if (k >= v->len)
+    {
+        vec_sort(v);
+        return;
+    }
+    VEC_STAT(v, sorts, 1);
+    heap_make(&h, k);
+    for (i = k; i < v->len && k; i++)
+    {
+        if (HEAP_LESS(&h, i, 0))
+        {
+            vec_elem_swap(HEAP_AT(&h, i), h.base, h.elem_size);
+            heap_sift_down(&h, 0, k);
+        }
+    }
+    heap_sort_made(&h, k);
 }
 
-void vec_sort(Vec *v)
+int vec_top_k(Vec *v, size_t k, Vec *out)
+{
+    heap_view h;
+    size_t i, m;
+    VALIDATE_VECTOR(out);
+    if (!vec_heap_view(v, 2, &h, "vec_top_k: Compare function is undefined.") || v->elem_size != out->elem_size || v == out)
+        return 1;
+    VEC_STAT(v, sorts, 1);
+    vec_clear(out);
+    m = k < v->len ? k : v->len;
+    vec_insert_n(out, 0, v->data, m);
+    /* min heap of the k greatest seen so far */
+    h.base = out->data;
+    h.dir = -1;
+    heap_make(&h, m);
+    for (i = m; i < v->len && m; i++)
+    {
+        byte *elem = vec_at(v, i);
+        if (v->cmp(elem, out->data) > 0)
+        {
+            memcpy(out->data, elem, v->elem_size * sizeof(byte));
+            heap_sift_down(&h, 0, m);
+        }
+    }
+    heap_sort_made(&h, m);
+    return 0;
+}
+
+size_t vec_unique(Vec *v)
 {
     VALIDATE_VECTOR(v);
     if (!v->cmp)
     {
-        perror("vec_sort: Compare function is undefined.");
-        return;
+        perror("vec_unique: Compare function is undefined.");
+        return 0;
     }
-    qsort(v->data, v->len, v->elem_size, v->cmp);
+    if (v->len < 2)
+        return 0;
+    size_t read, write = 1, run = 1;
+    for (read = 1; read < v->len; read++)
+    {
+        byte *elem = vec_at(v, read);
+        if (v->cmp(vec_at(v, write - 1), elem) != 0)
+        {
+            /* release the duplicates before the next kept entry can be copied over them */
+            vec_release(v, run, read - run);
+            if (write != read)
+                memcpy(vec_at(v, write), elem, v->elem_size * sizeof(byte));
+            write++;
+            run = read + 1;
+        }
+    }
+    vec_release(v, run, read - run);
+    read = v->len - write;
+    v->len = write;
+    return read;
 }
 
-void vec_insert(Vec *v, size_t index, void *data)
+/* first index in [lo, n) whose element is not less than key, probing 1, 2, 4... ahead of lo before bisecting */
+static size_t gallop_lower_bound(const byte *base, size_t lo, size_t n, size_t elem_size, void_cmp_func cmp, const void *key)
 {
-    VALIDATE_VECTOR(v);
-    if (index > v->len)
+    size_t step = 1, hi = lo;
+    while (hi < n && cmp(base + hi * elem_size, key) < 0)
+    {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    if (hi > n)
+        hi = n;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (cmp(base + mid * elem_size, key) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* appends count elements to dest, capacity must already be reserved */
+static void set_emit(Vec *dest, const byte *src, size_t count)
+{
+    if (!count)
         return;
+    VEC_STAT(dest, bytes_copied, count * dest->elem_size);
+    memcpy(vec_at(dest, dest->len), src, count * dest->elem_size * sizeof(byte));
+    dest->len += count;
+}
 
-    if (v->len >= v->capacity)
-        vec_resize(v, v->grow(v));
+static int set_prepare(Vec *dest, Vec *a, Vec *b, size_t reserve, const char *err)
+{
+    VALIDATE_VECTOR(dest);
+    if (!a->cmp)
+    {
+        perror(err);
+        return 0;
+    }
+    if (a->elem_size != b->elem_size || a->elem_size != dest->elem_size || dest == a || dest == b)
+        return 0;
+    vec_clear(dest);
+    vec_reserve(dest, reserve);
+    return 1;
+}
 
-    memmove(vec_at(v, index + 1), vec_at(v, index), (v->len - index) * v->elem_size * sizeof(byte));
-    memcpy(vec_at(v, index), data, v->elem_size);
+/* gallop through the larger input when it is this many times longer than the smaller one */
+#define VEC_GALLOP_RATIO 32
+#define SET_LOPSIDED(na, nb) ((na) / VEC_GALLOP_RATIO > (nb) || (nb) / VEC_GALLOP_RATIO > (na))
 
-    v->len++;
+int vec_set_union(Vec *dest, Vec *a, Vec *b)
+{
+    VALIDATE_VECTOR(a);
+    VALIDATE_VECTOR(b);
+    if (!set_prepare(dest, a, b, a->len + b->len, "vec_set_union: Compare function is undefined."))
+        return 1;
+    size_t es = a->elem_size, i = 0, j = 0;
+    void_cmp_func cmp = a->cmp;
+    if (SET_LOPSIDED(a->len, b->len))
+    {
+        Vec *small = a->len < b->len ? a : b, *large = small == a ? b : a;
+        for (i = 0; i < small->len; i++)
+        {
+            byte *x = vec_at(small, i);
+            size_t lb = gallop_lower_bound(large->data, j, large->len, es, cmp, x);
+            set_emit(dest, vec_at(large, j), lb - j);
+            j = lb;
+            if (j < large->len && cmp(vec_at(large, j), x) == 0)
+            {
+                set_emit(dest, small == a ? x : vec_at(large, j), 1);
+                j++;
+            }
+            else
+            {
+                set_emit(dest, x, 1);
+            }
+        }
+        set_emit(dest, vec_at(large, j), large->len - j);
+        return 0;
+    }
+    while (i < a->len && j < b->len)
+    {
+        int c = cmp(vec_at(a, i), vec_at(b, j));
+        if (c <= 0)
+        {
+            set_emit(dest, vec_at(a, i++), 1);
+            j += c == 0;
+        }
+        else
+        {
+            set_emit(dest, vec_at(b, j++), 1);
+        }
+    }
+    set_emit(dest, vec_at(a, i), a->len - i);
+    set_emit(dest, vec_at(b, j), b->len - j);
+    return 0;
 }
 
-void vec_clear(Vec *v)
+/* typed merge intersection for the built in integer comparators, returns the number of elements written to out */
+#define SET_INTERSECT_SCALAR(name, T)                                                                 \
+    static size_t name(const T *a, size_t na, const T *b, size_t nb, T *out)                          \
+    {                                                                                                 \
+        size_t i = 0, j = 0, k = 0;                                                                   \
+        while (i < na && j < nb)                                                                      \
+        {                                                                                             \
+            T x = a[i], y = b[j];                                                                     \
+            out[k] = x;                                                                               \
+            k += x == y;                                                                              \
+            i += x <= y;                                                                              \
+            j += y <= x;                                                                              \
+        }                                                                                             \
+        return k;                                                                                     \
+    }
+
+SET_INTERSECT_SCALAR(set_intersect_i32, int)
+SET_INTERSECT_SCALAR(set_intersect_u32, unsigned int)
+SET_INTERSECT_SCALAR(set_intersect_i64, long long)
+SET_INTERSECT_SCALAR(set_intersect_u64, unsigned long long)
+
+#ifdef VEC_HAVE_SSE2
+/* compares blocks of 4 against all 4 rotations of the other block, the block with the smaller last element advances */
+#define SET_INTERSECT_SSE2(name, T, scalar)                                                           \
+    static size_t name(const T *a, size_t na, const T *b, size_t nb, T *out)                          \
+    {                                                                                                 \
+        size_t i = 0, j = 0, k = 0;                                                                   \
+        while (i + 4 <= na && j + 4 <= nb)                                                            \
+        {                                                                                             \
+            __m128i va = _mm_loadu_si128((const __m128i *)(a + i));                                   \
+            __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));                                   \
+            __m128i eq = _mm_or_si128(                                                                \
+                _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39))), \
+                _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4E)),                        \
+                             _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93))));                      \
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));                                         \
+            while (mask)                                                                              \
+            {                                                                                         \
+                int bit = mask & -mask;                                                               \
+                out[k++] = a[i + (bit == 1 ? 0 : bit == 2 ? 1 : bit == 4 ? 2 : 3)];                  \
+                mask ^= bit;                                                                          \
+            }                                                                                         \
+            T amax = a[i + 3], bmax = b[j + 3];                                                       \
+            i += (amax <= bmax) * 4;                                                                  \
+            j += (bmax <= amax) * 4;                                                                  \
+        }                                                                                             \
+        return k + scalar(a + i, na - i, b + j, nb - j, out + k);                                     \
+    }
+
+SET_INTERSECT_SSE2(set_intersect_i32_sse2, int, set_intersect_i32)
+SET_INTERSECT_SSE2(set_intersect_u32_sse2, unsigned int, set_intersect_u32)
+#endif
+
+int vec_set_intersection(Vec *dest, Vec *a, Vec *b)
 {
-    VALIDATE_VECTOR(v);
-    if (v->free_entry)
+    VALIDATE_VECTOR(a);
+    VALIDATE_VECTOR(b);
+    if (!set_prepare(dest, a, b, a->len < b->len ? a->len : b->len, "vec_set_intersection: Compare function is undefined."))
+        return 1;
+    size_t es = a->elem_size, i = 0, j = 0;
+    void_cmp_func cmp = a->cmp;
+    if (SET_LOPSIDED(a->len, b->len))
+    {
+        Vec *small = a->len < b->len ? a : b, *large = small == a ? b : a;
+        for (i = 0; i < small->len && j < large->len; i++)
+        {
+            byte *x = vec_at(small, i);
+            j = gallop_lower_bound(large->data, j, large->len, es, cmp, x);
+            if (j < large->len && cmp(vec_at(large, j), x) == 0)
+            {
+                set_emit(dest, small == a ? x : vec_at(large, j), 1);
+                j++;
+            }
+        }
+        return 0;
+    }
+#ifdef VEC_HAVE_SSE2
+    if (cmp == vec_int_cmp && es == sizeof(int) && sizeof(int) == 4)
+        dest->len = set_intersect_i32_sse2((int *)a->data, a->len, (int *)b->data, b->len, (int *)dest->data);
+    else if (cmp == vec_uint_cmp && es == sizeof(unsigned int) && sizeof(unsigned int) == 4)
+        dest->len = set_intersect_u32_sse2((unsigned int *)a->data, a->len, (unsigned int *)b->data, b->len, (unsigned int *)dest->data);
+#else
+    if (cmp == vec_int_cmp && es == sizeof(int))
+        dest->len = set_intersect_i32((int *)a->data, a->len, (int *)b->data, b->len, (int *)dest->data);
+    else if (cmp == vec_uint_cmp && es == sizeof(unsigned int))
+        dest->len = set_intersect_u32((unsigned int *)a->data, a->len, (unsigned int *)b->data, b->len, (unsigned int *)dest->data);
+#endif
+    else if (cmp == vec_ll_cmp && es == sizeof(long long))
+        dest->len = set_intersect_i64((long long *)a->data, a->len, (long long *)b->data, b->len, (long long *)dest->data);
+    else if (cmp == vec_ull_cmp && es == sizeof(unsigned long long))
+        dest->len = set_intersect_u64((unsigned long long *)a->data, a->len, (unsigned long long *)b->data, b->len, (unsigned long long *)dest->data);
+    else
+    {
+        while (i < a->len && j < b->len)
+        {
+            int c = cmp(vec_at(a, i), vec_at(b, j));
+            if (c == 0)
+                set_emit(dest, vec_at(a, i), 1);
+            i += c <= 0;
+            j += c >= 0;
+        }
+    }
+    return 0;
+}
+
+int vec_set_difference(Vec *dest, Vec *a, Vec *b)
+{
+    VALIDATE_VECTOR(a);
+    VALIDATE_VECTOR(b);
+    if (!set_prepare(dest, a, b, a->len, "vec_set_difference: Compare function is undefined."))
+        return 1;
+    size_t es = a->elem_size, i = 0, j = 0;
+    void_cmp_func cmp = a->cmp;
+    if (SET_LOPSIDED(a->len, b->len) && a->len < b->len)
+    {
+        /* few elements to keep, look each one up in b */
+        for (i = 0; i < a->len; i++)
+        {
+            byte *x = vec_at(a, i);
+            j = gallop_lower_bound(b->data, j, b->len, es, cmp, x);
+            if (j >= b->len || cmp(vec_at(b, j), x) != 0)
+                set_emit(dest, x, 1);
+        }
+        return 0;
+    }
+    if (SET_LOPSIDED(a->len, b->len))
     {
-        void *var;
-        V_FOR_EACH_ANSI(v, var)
+        /* few elements to drop, copy the runs of a between them */
+        for (j = 0; j < b->len && i < a->len; j++)
         {
-            v->free_entry(var);
+            byte *y = vec_at(b, j);
+            size_t lb = gallop_lower_bound(a->data, i, a->len, es, cmp, y);
+            set_emit(dest, vec_at(a, i), lb - i);
+            i = lb;
+            if (i < a->len && cmp(vec_at(a, i), y) == 0)
+                i++;
         }
+        set_emit(dest, vec_at(a, i), a->len - i);
+        return 0;
+    }
+    while (i < a->len && j < b->len)
+    {
+        int c = cmp(vec_at(a, i), vec_at(b, j));
+        if (c < 0)
+            set_emit(dest, vec_at(a, i), 1);
+        i += c <= 0;
+        j += c >= 0;
     }
-    memset(v->data, 0, v->capacity * v->elem_size * sizeof(byte));
+    set_emit(dest, vec_at(a, i), a->len - i);
+    return 0;
+}
+
+void vec_clear(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    vec_release(v, 0, v->len);
     v->len = 0;
+    vec_maybe_shrink(v);
+    /* a vector created with capacity 0 has no data until its first push */
+    if (v->data && !(v->flags & VEC_FLAG_NO_ZERO))
+        memset(v->data, 0, v->capacity * v->elem_size * sizeof(byte));
 }
 
 /*  void vec_clear(Vec *v) */
@@ -202,12 +1720,18 @@ void vec_clamp(Vec *v)
     VALIDATE_VECTOR(v);
     byte *tmp;
     if (!v->len)
-        tmp = (byte *)realloc(v->data, v->elem_size * sizeof(byte));
+        tmp = vec_storage_realloc(v, v->elem_size * sizeof(byte));
     else
-        tmp = (byte *)realloc(v->data, v->len * v->elem_size * sizeof(byte));
+        tmp = vec_storage_realloc(v, v->len * v->elem_size * sizeof(byte));
     VEC_ASSERT(tmp);
+    size_t old_cap = v->capacity;
     v->data = tmp;
     v->capacity = v->len;
+    free(v->scratch);
+    v->scratch = NULL;
+    v->scratch_size = 0;
+    if (v->len != old_cap)
+        vec_trace(v, v->len > old_cap ? VEC_EVENT_GROW : VEC_EVENT_SHRINK, old_cap, v->len, v->len * v->elem_size);
 }
 
 void *vec_pop_back(Vec *v)
@@ -215,7 +1739,9 @@ void *vec_pop_back(Vec *v)
     VALIDATE_VECTOR(v);
     if (v->len < 1)
         return NULL;
-    return vec_at(v, --v->len);
+    v->len--;
+    vec_maybe_shrink(v);
+    return vec_at(v, v->len);
 }
 
 void *vec_find(Vec *v, void *_find)
@@ -229,6 +1755,7 @@ void *vec_find(Vec *v, void *_find)
     size_t i;
     for (i = 0; i < v->len; i++)
     {
+        VEC_STAT(v, find_cmps, 1);
         if (v->cmp(vec_at(v, i), _find) == 0)
         {
             return vec_at(v, i);
@@ -248,6 +1775,7 @@ size_t vec_find_idx(Vec* v, void* _find)
     size_t i;
     for (i = 0; i < v->len; i++)
     {
+        VEC_STAT(v, find_cmps, 1);
         if (v->cmp(vec_at(v, i), _find) == 0)
         {
             return i;
@@ -256,6 +1784,23 @@ size_t vec_find_idx(Vec* v, void* _find)
     return INVALID_FE_IDX;
 }
 
+/* removal without touching fe_idx, index must be in bounds */
+static void vec_remove_at(Vec *v, size_t index)
+{
+    if (index < v->len - 1)
+    {
+        vec_move(v, vec_at(v, index), vec_at(v, index + 1), (v->len - index - 1) * v->elem_size * sizeof(byte));
+    }
+    v->len--;
+}
+
+static void vec_remove_fast_at(Vec *v, size_t index)
+{
+    VEC_STAT(v, bytes_copied, v->elem_size);
+    memcpy(vec_at(v, index), vec_at(v, v->len - 1), v->elem_size * sizeof(byte));
+    v->len--;
+}
+
 void vec_remove(Vec *v, size_t index)
 {
     VALIDATE_VECTOR(v);
@@ -265,12 +1810,8 @@ void vec_remove(Vec *v, size_t index)
     {
         v->fe_idx--;
     }
-    if (index < v->len - 1)
-    {
-        memmove(vec_at(v, index), vec_at(v, index + 1), (v->len - index - 1) * v->elem_size * sizeof(byte));
-    }
-
-    v->len--;
+    vec_remove_at(v, index);
+    vec_maybe_shrink(v);
 }
 
 void vec_remove_fast(Vec *v, size_t index)
@@ -282,8 +1823,69 @@ void vec_remove_fast(Vec *v, size_t index)
     {
         v->fe_idx--;
     }
-    memcpy(vec_at(v, index), vec_at(v, v->len - 1), v->elem_size * sizeof(byte));
-    v->len--;
+    vec_remove_fast_at(v, index);
+    vec_maybe_shrink(v);
+}
+
+/* compacts the vector in one pass, keeping the elements for which (pred != 0) == keep */
+static size_t vec_compact(Vec *v, vec_pred_func pred, void *ctx, int keep)
+{
+    size_t read, write = 0, run = 0;
+    for (read = 0; read < v->len; read++)
+    {
+        byte *elem = vec_at(v, read);
+        if ((pred(elem, ctx) != 0) == keep)
+        {
+            /* release the dropped run before the next kept entry can be copied over it */
+            vec_release(v, run, read - run);
+            if (write != read)
+                memcpy(vec_at(v, write), elem, v->elem_size * sizeof(byte));
+            write++;
+            run = read + 1;
+        }
+    }
+    vec_release(v, run, read - run);
+    read = v->len - write;
+    v->len = write;
+    return read;
+}
+
+size_t vec_remove_if(Vec *v, vec_pred_func pred, void *ctx)
+{
+    VALIDATE_VECTOR(v);
+    if (!pred)
+        return 0;
+    return vec_compact(v, pred, ctx, 0);
+}
+
+size_t vec_retain(Vec *v, vec_pred_func pred, void *ctx)
+{
+    VALIDATE_VECTOR(v);
+    if (!pred)
+        return 0;
+    return vec_compact(v, pred, ctx, 1);
+}
+
+void vec_remove_range(Vec *v, size_t first, size_t count)
+{
+    VALIDATE_VECTOR(v);
+    if (first >= v->len || !count)
+        return;
+    if (count > v->len - first)
+        count = v->len - first;
+    /* keep V_FOR_EACH on the entry that followed the removed ones */
+    if (v->fe_idx != INVALID_FE_IDX && v->fe_idx >= first)
+    {
+        if (v->fe_idx - first < count)
+            v->fe_idx = first - 1;
+        else
+            v->fe_idx -= count;
+    }
+    if (first + count < v->len)
+    {
+        vec_move(v, vec_at(v, first), vec_at(v, first + count), (v->len - first - count) * v->elem_size * sizeof(byte));
+    }
+    v->len -= count;
 }
 
 /* Returns heap allocated deep copy */
@@ -292,30 +1894,53 @@ Vec *vec_copy(Vec *v)
     VALIDATE_VECTOR(v);
     Vec *ret = (Vec *)malloc(sizeof(Vec));
     VEC_ASSERT(ret);
-    ret->grow = v->grow;
-    ret->cmp = v->cmp;
-    ret->elem_size = v->elem_size;
-    ret->len = 0;
-    ret->data = NULL;
-    ret->capacity = 0;
-    vec_resize(ret, v->capacity);
+    *ret = (Vec){.elem_size = v->elem_size,
+                 .capacity = 0,
+                 .len = 0,
+                 .data = NULL,
+                 .cmp = v->cmp,
+                 .grow = v->grow,
+                 .shrink = v->shrink,
+                 .align = v->align,
+                 .flags = v->flags & VEC_FLAG_NO_ZERO};
+#ifdef VEC_ENABLE_BUDGET
+    ret->budget = v->budget;
+#endif
+    /* only the memory past len is zeroed, the rest is written once by the copy */
+    vec_resize_impl(ret, v->capacity, 0);
     if (v->capacity == 0)
     {
         return ret;
     }
     VEC_ASSERT(ret->data && ret->capacity == v->capacity);
-    memcpy(ret->data, v->data, v->capacity);
+    VEC_STAT(v, bytes_copied, v->len * v->elem_size);
+    vec_bulk_copy(ret->data, v->data, v->len * v->elem_size * sizeof(byte));
+    ret->len = v->len;
+    if (!(ret->flags & VEC_FLAG_NO_ZERO))
+        memset(vec_at(ret, ret->len), 0, (ret->capacity - ret->len) * ret->elem_size * sizeof(byte));
     return ret;
 }
 
 void vec_reverse(Vec *v)
 {
     VALIDATE_VECTOR(v);
-    size_t i;
-    for (i = 0; i < v->len / 2; i++)
-    {
-        vec_swap(v, i, v->len - i - 1);
-    }
+    if (v->len < 2)
+        return;
+    vec_reverse_block(v->data, v->len, v->elem_size);
+}
+
+void vec_rotate(Vec *v, size_t k)
+{
+    VALIDATE_VECTOR(v);
+    if (v->len < 2)
+        return;
+    k %= v->len;
+    if (k == 0)
+        return;
+    /* (A B) -> (A' B') -> (B A) */
+    vec_reverse_block(v->data, k, v->elem_size);
+    vec_reverse_block(v->data + k * v->elem_size, v->len - k, v->elem_size);
+    vec_reverse_block(v->data, v->len, v->elem_size);
 }
 
 void vec_swap(Vec *v, size_t idx0, size_t idx1)
@@ -325,18 +1950,9 @@ void vec_swap(Vec *v, size_t idx0, size_t idx1)
         return;
     if (idx1 >= v->len)
         return;
-
-    size_t write_size = v->elem_size;
-    byte *idx0_entry = vec_at(v, idx0);
-    byte *idx1_entry = vec_at(v, idx1);
-    while (write_size)
-    {
-        size_t idx = write_size - 1;
-        byte tmp = idx0_entry[idx];
-        idx0_entry[idx] = idx1_entry[idx];
-        idx1_entry[idx] = tmp;
-        write_size--;
-    }
+    if (idx0 == idx1)
+        return;
+    vec_elem_swap(vec_at(v, idx0), vec_at(v, idx1), v->elem_size);
 }
 
 void *vec_pop_front(Vec *v)
@@ -344,9 +1960,9 @@ void *vec_pop_front(Vec *v)
     VALIDATE_VECTOR(v);
     if (v->len < 1)
         return NULL;
-    void *ret = vec_at(v, 0);
     vec_remove(v, 0);
-    return ret;
+    /* read after the removal, a shrink may have moved data */
+    return vec_at(v, 0);
 }
 
 size_t vec_size(Vec *v)
@@ -356,16 +1972,18 @@ size_t vec_size(Vec *v)
 
 int vec_append(Vec *dest, Vec *source)
 {
+    VALIDATE_VECTOR(dest);
+    VALIDATE_VECTOR(source);
     if (dest->elem_size != source->elem_size)
         return 1;
-    size_t i;
-    for (i = 0; i < source->capacity; i++)
-    {
-        void *data = vec_at_s(source, i);
-        if (!data)
-            return 2;
-        vec_push_back(dest, data);
-    }
+    /* read before the reserve, which also grows source when appending a vector to itself */
+    size_t count = source->len;
+    if (!count)
+        return 0;
+    vec_reserve(dest, dest->len + count);
+    VEC_STAT(dest, bytes_copied, count * dest->elem_size);
+    vec_bulk_copy(vec_at(dest, dest->len), source->data, count * dest->elem_size * sizeof(byte));
+    dest->len += count;
     return 0;
 }
 
@@ -376,5 +1994,42 @@ void *vec_arr_copy(Vec *v, size_t *ret_elem_count)
     void *copy = malloc(v->elem_size * v->len);
     if (ret_elem_count)
         *ret_elem_count = v->len;
-    return memcpy(copy, v->data, v->len * v->elem_size);
+    VEC_STAT(v, bytes_copied, v->len * v->elem_size);
+    vec_bulk_copy(copy, v->data, v->len * v->elem_size);
+    return copy;
+}
+
+VecIter vec_iter(Vec *v)
+{
+    VALIDATE_VECTOR(v);
+    VecIter it = {.vec = v, .idx = INVALID_FE_IDX};
+    return it;
+}
+
+void *vec_iter_next(VecIter *it)
+{
+    /* INVALID_FE_IDX wraps to 0 on the first call */
+    it->idx++;
+    if (it->idx >= it->vec->len)
+    {
+        it->idx = it->vec->len;
+        return NULL;
+    }
+    return vec_at(it->vec, it->idx);
+}
+
+void vec_iter_remove(VecIter *it)
+{
+    if (it->idx >= it->vec->len)
+        return;
+    vec_remove_at(it->vec, it->idx);
+    it->idx--;
+}
+
+void vec_iter_remove_fast(VecIter *it)
+{
+    if (it->idx >= it->vec->len)
+        return;
+    vec_remove_fast_at(it->vec, it->idx);
+    it->idx--;
 }
\ No newline at end of file
@@ -21,6 +21,12 @@ extern "C"
 
 #include <stdint.h>
 #include <stddef.h>
+#ifdef VEC_ENABLE_STATS
+#include <stdio.h>
+#endif
+#ifdef VEC_ENABLE_BUDGET
+#include "vector budget.h"
+#endif
 
     /*
         INFO:
@@ -63,8 +69,61 @@ extern "C"
 
 #define INVALID_FE_IDX ((size_t) - 1)
 
+#define VEC_CACHE_LINE 64
+
+    /*
+        Define VEC_DISABLE_MMAP to keep large vectors on the heap.
+        On Linux, storage of at least VEC_MMAP_THRESHOLD bytes is mapped with mmap,
+        advised for transparent huge pages and grown with mremap instead of a realloc copy.
+    */
+
+#ifndef VEC_MMAP_THRESHOLD
+#define VEC_MMAP_THRESHOLD ((size_t)32 * 1024 * 1024)
+#endif
+
+    /*
+        Copies of at least VEC_STREAM_THRESHOLD bytes by vec_copy, vec_arr_copy, vec_append and storage moves
+        use non temporal stores where SSE2 is available, so data that is not read again soon does not evict the cache.
+        Copies of at least VEC_COPY_THREAD_BYTES are split between up to VEC_COPY_MAX_THREADS threads,
+        link pthreads on POSIX systems. Define VEC_DISABLE_THREADS to keep every copy on the calling thread.
+    */
+
+#ifndef VEC_STREAM_THRESHOLD
+#define VEC_STREAM_THRESHOLD ((size_t)8 * 1024 * 1024)
+#endif
+
+#ifndef VEC_COPY_THREAD_BYTES
+#define VEC_COPY_THREAD_BYTES ((size_t)64 * 1024 * 1024)
+#endif
+
+#ifndef VEC_COPY_MAX_THREADS
+#define VEC_COPY_MAX_THREADS 8
+#endif
+
+/* Vec.flags */
+#define VEC_FLAG_MMAP 0x1u    /* set by the library while data is an mmap mapping */
+#define VEC_FLAG_NO_ZERO 0x2u /* vec_resize and vec_clear leave memory past len uninitialized */
+
     typedef uint8_t byte;
 
+    /*
+        Define VEC_ENABLE_STATS (for every file that includes this header) to count allocation and copy traffic
+        per vector in v->stats and for the whole process. Without it the counters compile to nothing.
+    */
+
+#ifdef VEC_ENABLE_STATS
+    typedef struct VecStats
+    {
+        size_t reallocs;      /* calls into the allocator to resize data */
+        size_t bytes_moved;   /* memmove traffic of insertions and removals */
+        size_t bytes_copied;  /* memcpy traffic of pushes, inserts, copies and fast removals */
+        size_t peak_capacity; /* largest capacity reached, in elements */
+        size_t peak_bytes;    /* largest data allocation, in bytes */
+        size_t find_cmps;     /* cmp calls made by the linear searches */
+        size_t sorts;         /* calls to the sort, partial sort and selection functions */
+    } VecStats;
+#endif
+
     typedef struct Vec Vec;
 
     /* 0 if eq, -1 if less, 1 if greater than */
@@ -86,8 +145,53 @@ extern "C"
      */
     typedef size_t (*vec_growth_rate_func)(Vec *);
 
+    /**
+     * @brief returns the capacity to shrink to after a removal, v->capacity to keep the current allocation
+     *
+     */
+    typedef size_t (*vec_shrink_func)(Vec *);
+
+    /**
+     * @brief Shrink policy with hysteresis, halves the capacity once len drops below a quarter of it.
+     *
+     * @details Never shrinks below VECTOR_DEFAULT_CAP. After a shrink the vector is half full,
+     * so alternating pushes and pops can not make it resize back and forth.
+     */
+    size_t vec_shrink_hysteresis(Vec *v);
+
+    typedef enum
+    {
+        VEC_EVENT_GROW,    /* data was resized to a larger capacity */
+        VEC_EVENT_SHRINK,  /* data was resized to a smaller capacity */
+        VEC_EVENT_MEMMOVE, /* an insertion or removal moved at least the trace memmove threshold */
+    } VecEvent;
+
+    /**
+     * @brief Trace hook, bytes is the new allocation size for resizes and the moved size for memmoves.
+     *
+     */
+    typedef void (*vec_trace_func)(Vec *v, VecEvent event, size_t old_cap, size_t new_cap, size_t bytes, const char *tag);
+
+    /**
+     * @brief Predicate used by the bulk removal functions, returns non zero when it matches the element.
+     *
+     */
+    typedef int (*vec_pred_func)(const void *elem, void *ctx);
+
+    /**
+     * @brief Range destructor, called once per contiguous run of count entries starting at first that the vector drops.
+     *
+     */
+    typedef void (*vec_free_range_func)(void *first, size_t count, size_t elem_size);
+
     void vec_deref_free(const void *data);
 
+    /**
+     * @brief Range version of vec_deref_free, frees the pointer stored at the start of every entry of the run.
+     *
+     */
+    void vec_deref_free_range(void *first, size_t count, size_t elem_size);
+
     struct Vec
     {
         byte *data;
@@ -97,7 +201,21 @@ extern "C"
         void_cmp_func cmp;
         vec_growth_rate_func grow;
         void (*free_entry)(const void *);
+        vec_free_range_func free_range; /* used instead of free_entry when set, lets the destructor batch its work */
+        vec_shrink_func shrink; /* NULL to never shrink automatically */
+        vec_trace_func trace;   /* overrides the global trace hook for this vector */
+        const char *trace_tag;  /* handed to the trace hook, names the owner of the vector */
         size_t fe_idx; /* use by VEC_FOR_EACH to ensure index after altering the vector */
+        byte *scratch;       /* merge buffer kept by vec_stable_sort between calls */
+        size_t scratch_size; /* size of scratch in bytes */
+        size_t align;        /* alignment of data in bytes, 0 for the malloc default */
+        unsigned int flags;  /* VEC_FLAG_* */
+#ifdef VEC_ENABLE_STATS
+        VecStats stats;
+#endif
+#ifdef VEC_ENABLE_BUDGET
+        VecBudget *budget; /* group charged besides the global budget, change it with vec_set_budget */
+#endif
     };
 
 /**
@@ -105,6 +223,11 @@ extern "C"
  *
  */
 #define VEC(type) (vec_new(VECTOR_DEFAULT_CAP, sizeof(type), NULL, NULL, NULL))
+/**
+ * @brief Quick macro to create a new vector whose data starts on a cache line.
+ *
+ */
+#define VEC_ALIGNED(type) (vec_new_aligned(VECTOR_DEFAULT_CAP, sizeof(type), VEC_CACHE_LINE, NULL, NULL, NULL))
 #define V_ADD(v, data) (vec_push_back(v, data))
 #define V_INS(v, idx, data) (vec_insert(v, idx, data))
 #define V_RM(v, idx) (vec_remove(v, idx))
@@ -131,6 +254,22 @@ extern "C"
          var_name != NULL;                              \
          var_name = vec_at_s(vec, ++((vec)->fe_idx)))
 #endif
+#if __STDC_VERSION__ >= 199901L
+/* Walks the vector with a raw pointer and a fixed stride of elem_size bytes, no per step checks.
+    The end pointer is computed once, so the vector must not be added to or removed from inside the loop.
+    Does not use fe_idx, so it can be nested over the same vector. */
+#define V_FOR_EACH_FAST(vec, type, var_name)                                                      \
+    for (type *var_name = (type *)(vec)->data,                                                    \
+              *var_name##_end = (type *)((vec)->data + (vec)->len * (vec)->elem_size);           \
+         var_name < var_name##_end;                                                               \
+         var_name = (type *)((byte *)var_name + (vec)->elem_size))
+#endif
+/* Same as V_FOR_EACH_FAST, but expects the user to allocate the var_name as a pointer to type.
+    The end is recomputed every step but the vector must still not be altered inside the loop. */
+#define V_FOR_EACH_FAST_ANSI(vec, var_name)                                  \
+    for (var_name = (void *)(vec)->data;                                    \
+         (byte *)var_name < (vec)->data + (vec)->len * (vec)->elem_size;   \
+         var_name = (void *)((byte *)var_name + (vec)->elem_size))
 /* Same as V_FOR_EACH, but expects the user to allocate the var_name as a pointer to type.
     Accommodates adding and removing entries but not inserting before the current index.
     You can still insert before the current index, but it will make you iterate over the current entry again
@@ -140,6 +279,89 @@ extern "C"
     for (var_name = vec_at_s(vec, (vec)->fe_idx); \
          var_name != NULL;                        \
          var_name = vec_at_s(vec, ++((vec)->fe_idx)))
+
+    /**
+     * @brief Stack allocated cursor over a vector, use instead of fe_idx when loops are nested or re-entrant.
+     *
+     * @details Start one with vec_iter, advance it with vec_iter_next and remove the current entry with
+     * vec_iter_remove or vec_iter_remove_fast, which keep the cursor valid like V_FOR_EACH does with fe_idx.
+     */
+    typedef struct VecIter
+    {
+        Vec *vec;
+        size_t idx; /* index of the current entry, INVALID_FE_IDX before the first vec_iter_next */
+    } VecIter;
+
+/* Iterates with a user allocated VecIter, which must have been started with vec_iter.
+    Safe to nest and to remove the current entry through vec_iter_remove or vec_iter_remove_fast. */
+#define V_ITER_EACH_ANSI(iter, var_name)           \
+    for (var_name = vec_iter_next(&(iter));        \
+         var_name != NULL;                         \
+         var_name = vec_iter_next(&(iter)))
+#if __STDC_VERSION__ >= 199901L
+/* Generates a binary heap over a Vec of type with the comparison inlined: name##_make, name##_push,
+    name##_pop and name##_replace. less(a, b) is an expression or macro on two values of type, the greatest
+    element by less sits at index 0 like with vec_heap_make. The vector's elem_size must be sizeof(type). */
+#define VEC_HEAP_DEFINE(name, type, less)                                     \
+    static inline void name##_sift_down(type *a, size_t i, size_t n)         \
+    {                                                                         \
+        type hole = a[i];                                                     \
+        size_t child;                                                         \
+        while ((child = 2 * i + 1) < n)                                       \
+        {                                                                     \
+            if (child + 1 < n && less(a[child], a[child + 1]))                \
+                child++;                                                      \
+            if (!less(hole, a[child]))                                        \
+                break;                                                        \
+            a[i] = a[child];                                                  \
+            i = child;                                                        \
+        }                                                                     \
+        a[i] = hole;                                                          \
+    }                                                                         \
+    static inline void name##_make(Vec *v)                                    \
+    {                                                                         \
+        size_t i = v->len / 2;                                                \
+        while (i--)                                                           \
+            name##_sift_down((type *)v->data, i, v->len);                     \
+    }                                                                         \
+    static inline void name##_push(Vec *v, const type *value)                 \
+    {                                                                         \
+        type hole = *value;                                                   \
+        vec_push_back(v, &hole);                                              \
+        type *a = (type *)v->data;                                            \
+        size_t i = v->len - 1;                                                \
+        while (i > 0 && less(a[(i - 1) / 2], hole))                           \
+        {                                                                     \
+            a[i] = a[(i - 1) / 2];                                            \
+            i = (i - 1) / 2;                                                  \
+        }                                                                     \
+        a[i] = hole;                                                          \
+    }                                                                         \
+    static inline int name##_pop(Vec *v, type *out)                           \
+    {                                                                         \
+        type *a = (type *)v->data;                                            \
+        if (!v->len)                                                          \
+            return 0;                                                         \
+        *out = a[0];                                                          \
+        if (--v->len)                                                         \
+        {                                                                     \
+            a[0] = a[v->len];                                                 \
+            name##_sift_down(a, 0, v->len);                                   \
+        }                                                                     \
+        return 1;                                                             \
+    }                                                                         \
+    static inline void name##_replace(Vec *v, const type *value)              \
+    {                                                                         \
+        if (!v->len)                                                          \
+        {                                                                     \
+            name##_push(v, value);                                            \
+            return;                                                           \
+        }                                                                     \
+        ((type *)v->data)[0] = *value;                                        \
+        name##_sift_down((type *)v->data, 0, v->len);                         \
+    }
+#endif
+
     /**
      * @brief Dynamic array of bytes.
      *
@@ -152,6 +374,22 @@ extern "C"
      */
     Vec *vec_new(size_t capacity, size_t elem_size, void_cmp_func cmp, vec_growth_rate_func grow, void (*free_entry)(const void *));
 
+    /**
+     * @brief Same as vec_new but data is aligned to align bytes for its whole lifetime.
+     *
+     * @param capacity Capacity of the vector
+     * @param elem_size Size of each element in bytes
+     * @param align Power of two alignment of data in bytes, VEC_CACHE_LINE for cache line alignment. 0 is the same as vec_new.
+     * @param cmp Function to compare elements
+     * @param grow Function to determine the new capacity of the vector
+     * @param free_entry Function to free the memory of an element
+     * @return Vec*
+     *
+     * @details Aligned storage can not use realloc, so growing copies into a fresh aligned block
+     * until the vector is large enough to be mapped with mmap.
+     */
+    Vec *vec_new_aligned(size_t capacity, size_t elem_size, size_t align, void_cmp_func cmp, vec_growth_rate_func grow, void (*free_entry)(const void *));
+
     /**
      * @brief Free the memory of the vector.
      *
@@ -195,9 +433,40 @@ extern "C"
      *
      * @param v Vector to resize.
      * @param new_size New size of the vector.
+     *
+     * @details Shrinking below the length drops the entries past new_size through free_range or free_entry.
      */
     void vec_resize(Vec *v, size_t new_size);
 
+    /**
+     * @brief Same as vec_resize but never zero fills the grown region, whatever v->flags says.
+     *
+     * @param v Vector to resize.
+     * @param new_size New size of the vector.
+     */
+    void vec_resize_uninit(Vec *v, size_t new_size);
+
+    /**
+     * @brief Appends an uninitialized slot and returns it so the element can be built in place.
+     *
+     * @param v Vector to grow.
+     * @return void* Pointer to the new last element.
+     *
+     * @details The slot holds whatever was left in the buffer, zeroes on fresh memory unless VEC_FLAG_NO_ZERO is set.
+     * The pointer is valid until the vector is resized.
+     */
+    void *vec_emplace_back(Vec *v);
+
+    /**
+     * @brief Makes sure the vector can hold at least min_cap entries with a single resize.
+     *
+     * @param v Vector to grow.
+     * @param min_cap Minimum capacity required.
+     *
+     * @details Uses the growth function when it gives enough room, otherwise grows to exactly min_cap.
+     */
+    void vec_reserve(Vec *v, size_t min_cap);
+
     /**
      * @brief Sorts the vector using libc qsort.
      *
@@ -205,6 +474,37 @@ extern "C"
      */
     void vec_sort(Vec *v);
 
+    /**
+     * @brief Stable adaptive merge sort, elements that compare equal keep their order.
+     *
+     * @param v Vector to sort.
+     *
+     * @details Timsort style: natural ascending and descending runs are detected, so already sorted
+     * or reversed data is O(n). The merge buffer is kept in v->scratch and reused by the next call,
+     * it is released by vec_clamp and vec_free.
+     *
+     * @warning Expects a cmp function to be assigned to the vector.
+     */
+    void vec_stable_sort(Vec *v);
+
+    /**
+     * @brief Same as vec_stable_sort but merges through a caller supplied buffer instead of v->scratch.
+     *
+     * @param v Vector to sort.
+     * @param scratch Buffer of at least vec_stable_sort_scratch_size(v) bytes.
+     * @param scratch_size Size of scratch in bytes.
+     * @return int 0 on success, 1 on fail.
+     */
+    int vec_stable_sort_buf(Vec *v, void *scratch, size_t scratch_size);
+
+    /**
+     * @brief Returns the number of scratch bytes vec_stable_sort needs for the current length of the vector.
+     *
+     * @param v Vector to sort.
+     * @return size_t Size in bytes, half the vector rounded down but at least one element.
+     */
+    size_t vec_stable_sort_scratch_size(Vec *v);
+
     /**
      * @brief Inserts data into the vector at the specified index.
      *
@@ -213,10 +513,35 @@ extern "C"
      * @param data Data must be a valid memory address.
      */
     void vec_insert(Vec *v, size_t index, void *data);
+
+    /**
+     * @brief Inserts count elements copied from src at the specified index.
+     *
+     * @param v Vector to insert data into.
+     * @param index Index to insert data at.
+     * @param src Contiguous array of count elements of v->elem_size bytes, may point into v.
+     * @param count Number of elements to insert.
+     *
+     * @details Reserves once and shifts the tail once, O(n + count).
+     */
+    void vec_insert_n(Vec *v, size_t index, const void *src, size_t count);
+
+    /**
+     * @brief Inserts every element of other at the specified index.
+     *
+     * @param v Vector to insert data into.
+     * @param index Index to insert data at.
+     * @param other Vector to copy the elements from, can be v.
+     * @return int 0 on success, 1 on fail.
+     */
+    int vec_insert_vec(Vec *v, size_t index, Vec *other);
     /**
      * @brief Removes all entries from the vector, calls their free functions if one was given.
      *
      * @param v Vector to clear.
+     *
+     * @details free_range is called once for all entries, otherwise free_entry once per entry.
+     * Zeroes the whole allocation unless VEC_FLAG_NO_ZERO is set in v->flags.
      */
     void vec_clear(Vec *v);
 
@@ -224,6 +549,8 @@ extern "C"
      * @brief Resizes the vector to the current length.
      *
      * @param v Vector to resize.
+     *
+     * @details Also releases the vec_stable_sort scratch buffer.
      */
     void vec_clamp(Vec *v);
 
@@ -234,6 +561,16 @@ extern "C"
      */
     void vec_reverse(Vec *v);
 
+    /**
+     * @brief Rotates the vector left by k places, the element at index k becomes the first.
+     *
+     * @param v Vector to rotate.
+     * @param k Number of places, taken modulo the length of the vector.
+     *
+     * @details Done in place with three reversals, so it needs no extra memory.
+     */
+    void vec_rotate(Vec *v, size_t k);
+
     /**
      * @brief Swaps the elements at the specified indices.
      *
@@ -338,7 +675,9 @@ extern "C"
      *
      * @param dest Destination vector.
      * @param source Source vector.
-     * @return int 0 on success, 1 on fail, and 2 on partial fail.
+     * @return int 0 on success, 1 when the element sizes differ.
+     *
+     * @details Reserves once and copies source->len elements in one block, dest and source may be the same vector.
      */
     int vec_append(Vec *dest, Vec *source);
 
@@ -353,6 +692,318 @@ extern "C"
      */
     void *vec_arr_copy(Vec *v, size_t *ret_elem_count);
 
+    /**
+     * @brief Removes every element the predicate matches in a single linear pass, ensures the current order of the vec.
+     *
+     * @param v Vector to remove data from.
+     * @param pred Predicate called once per element.
+     * @param ctx User pointer handed to pred.
+     * @return size_t Number of elements removed.
+     *
+     * @details Calls free_range once per contiguous run of removed elements, or free_entry for each of them, if one was given.
+     */
+    size_t vec_remove_if(Vec *v, vec_pred_func pred, void *ctx);
+
+    /**
+     * @brief Keeps only the elements the predicate matches, the inverse of vec_remove_if.
+     *
+     * @param v Vector to remove data from.
+     * @param pred Predicate called once per element.
+     * @param ctx User pointer handed to pred.
+     * @return size_t Number of elements removed.
+     *
+     * @details Calls free_range once per contiguous run of removed elements, or free_entry for each of them, if one was given.
+     */
+    size_t vec_retain(Vec *v, vec_pred_func pred, void *ctx);
+
+    /**
+     * @brief Removes count elements starting at first with a single memmove, ensures the current order of the vec.
+     *
+     * @param v Vector to remove data from.
+     * @param first Index of the first element to remove.
+     * @param count Number of elements to remove, clipped to the end of the vector.
+     *
+     * @warning Does not call the free function of the data.
+     */
+    void vec_remove_range(Vec *v, size_t first, size_t count);
+
+    /**
+     * @brief Reorders the vector into a binary max heap by v->cmp, the greatest element ends up at index 0.
+     *
+     * @param v Vector to heapify.
+     *
+     * @warning Expects a cmp function to be assigned to the vector. Use a reversed cmp for a min heap.
+     */
+    void vec_heap_make(Vec *v);
+
+    /**
+     * @brief Copies data into the heap and restores the heap order, O(log n).
+     *
+     * @param v Vector holding a heap made by vec_heap_make.
+     * @param data A valid memory address which will be copied into the vector.
+     */
+    void vec_heap_push(Vec *v, void *data);
+
+    /**
+     * @brief Removes the greatest element from the heap, O(log n).
+     *
+     * @param v Vector holding a heap made by vec_heap_make.
+     * @return void* Pointer to the removed element. NULL if the heap is empty.
+     *
+     * @details Like vec_pop_back the element stays in the buffer just past v->len,
+     * the pointer is valid until the next element is added.
+     */
+    void *vec_heap_pop(Vec *v);
+
+    /**
+     * @brief Returns a pointer to the greatest element of the heap.
+     *
+     * @param v Vector holding a heap made by vec_heap_make.
+     * @return void* Pointer to the element at index 0. NULL if the heap is empty.
+     */
+    void *vec_heap_top(Vec *v);
+
+    /**
+     * @brief Overwrites the greatest element with data and restores the heap order, cheaper than a pop followed by a push.
+     *
+     * @param v Vector holding a heap made by vec_heap_make.
+     * @param data A valid memory address which will be copied into the vector.
+     */
+    void vec_heap_replace(Vec *v, void *data);
+
+    /**
+     * @brief Same as vec_heap_make but builds a 4-ary heap, which is shallower and touches fewer cache lines per sift.
+     *
+     * @param v Vector to heapify.
+     *
+     * @warning A 4-ary heap must only be used with the vec_heap4_* functions, vec_heap_top works for both.
+     */
+    void vec_heap4_make(Vec *v);
+
+    /**
+     * @brief vec_heap_push for a heap made by vec_heap4_make.
+     */
+    void vec_heap4_push(Vec *v, void *data);
+
+    /**
+     * @brief vec_heap_pop for a heap made by vec_heap4_make.
+     */
+    void *vec_heap4_pop(Vec *v);
+
+    /**
+     * @brief vec_heap_replace for a heap made by vec_heap4_make.
+     */
+    void vec_heap4_replace(Vec *v, void *data);
+
+    /**
+     * @brief Moves the element that would be at index n in sorted order to index n, O(n) on average.
+     *
+     * @param v Vector to partition.
+     * @param n Index of the element to select.
+     *
+     * @details Elements before n compare less or equal to it, elements after n compare greater or equal.
+     * Introselect: quickselect with a median of three pivot that falls back to a heap select when it recurses too deep.
+     *
+     * @warning Expects a cmp function to be assigned to the vector.
+     */
+    void vec_nth_element(Vec *v, size_t n);
+
+    /**
+     * @brief Sorts the k smallest elements into the front of the vector, O(n log k).
+     *
+     * @param v Vector to partially sort.
+     * @param k Number of elements to sort, the order of the remaining elements is unspecified.
+     *
+     * @warning Expects a cmp function to be assigned to the vector.
+     */
+    void vec_partial_sort(Vec *v, size_t k);
+
+    /**
+     * @brief Copies the k greatest elements of v into out in descending order, O(n log k), v is not modified.
+     *
+     * @param v Vector to search.
+     * @param k Number of elements to keep.
+     * @param out Vector with the same elem_size as v, it is cleared first.
+     * @return int 0 on success, 1 on fail.
+     *
+     * @warning Expects a cmp function to be assigned to v.
+     */
+    int vec_top_k(Vec *v, size_t k, Vec *out);
+
+    /**
+     * @brief Removes consecutive duplicates in place, keeping the first of each run, in a single pass.
+     *
+     * @param v Vector to deduplicate, sort it first to remove every duplicate.
+     * @return size_t Number of elements removed.
+     *
+     * @details Calls free_range once per run of removed duplicates, or free_entry for each of them, if one was given.
+     *
+     * @warning Expects a cmp function to be assigned to the vector.
+     */
+    size_t vec_unique(Vec *v);
+
+    /**
+     * @brief Writes the sorted union of a and b into dest.
+     *
+     * @param dest Destination vector, cleared first. Must not be a or b.
+     * @param a Sorted vector without duplicates, its cmp is used.
+     * @param b Sorted vector without duplicates.
+     * @return int 0 on success, 1 on fail.
+     *
+     * @details Gallops through the larger input when the sizes are very lopsided.
+     * Elements are copied bytewise, so dest should not own them with a free function.
+     */
+    int vec_set_union(Vec *dest, Vec *a, Vec *b);
+
+    /**
+     * @brief Writes the sorted intersection of a and b into dest.
+     *
+     * @param dest Destination vector, cleared first. Must not be a or b.
+     * @param a Sorted vector without duplicates, its cmp is used.
+     * @param b Sorted vector without duplicates.
+     * @return int 0 on success, 1 on fail.
+     *
+     * @details Gallops through the larger input when the sizes are very lopsided,
+     * vectors using the built in integer comparators take a typed (SSE2 for 32 bit) kernel otherwise.
+     * Elements are copied bytewise, so dest should not own them with a free function.
+     */
+    int vec_set_intersection(Vec *dest, Vec *a, Vec *b);
+
+    /**
+     * @brief Writes the elements of a that are not in b into dest, sorted.
+     *
+     * @param dest Destination vector, cleared first. Must not be a or b.
+     * @param a Sorted vector without duplicates, its cmp is used.
+     * @param b Sorted vector without duplicates.
+     * @return int 0 on success, 1 on fail.
+     *
+     * @details Gallops through the larger input when the sizes are very lopsided.
+     * Elements are copied bytewise, so dest should not own them with a free function.
+     */
+    int vec_set_difference(Vec *dest, Vec *a, Vec *b);
+
+    /**
+     * @brief Returns an iterator positioned before the first element of the vector.
+     *
+     * @param v Vector to iterate.
+     * @return VecIter Iterator to keep on the stack.
+     */
+    VecIter vec_iter(Vec *v);
+
+    /**
+     * @brief Advances the iterator.
+     *
+     * @param it Iterator to advance.
+     * @return void* Pointer to the next element. NULL once the end is reached.
+     */
+    void *vec_iter_next(VecIter *it);
+
+    /**
+     * @brief Removes the current entry of the iterator, ensures the current order of the vec.
+     *
+     * @param it Iterator whose current entry is removed.
+     *
+     * @details The next call to vec_iter_next returns the entry that followed the removed one.
+     * Does not alter v->fe_idx.
+     *
+     * @warning Does not call the free function of the data.
+     */
+    void vec_iter_remove(VecIter *it);
+
+    /**
+     * @brief Removes the current entry of the iterator, doesn't ensure the vec order.
+     *
+     * @param it Iterator whose current entry is removed.
+     *
+     * @details Swaps the last element into the current index, the next call to vec_iter_next returns it.
+     * Does not alter v->fe_idx.
+     *
+     * @warning Does not call the free function of the data.
+     */
+    void vec_iter_remove_fast(VecIter *it);
+
+#ifdef VEC_ENABLE_BUDGET
+    /**
+     * @brief Moves the vector to another budget group, its current allocation is transferred without checking limits.
+     *
+     * @param v Vector to move.
+     * @param budget Group to charge from now on, NULL for the global budget only.
+     *
+     * @details When an allocation would go over a hard limit the functions of this header assert,
+     * use the functions of "vector safe.h" to get FAILED_ALLOC back instead.
+     */
+    void vec_set_budget(Vec *v, VecBudget *budget);
+#endif
+
+#ifndef VEC_TRACE_MEMMOVE_THRESHOLD
+#define VEC_TRACE_MEMMOVE_THRESHOLD ((size_t)64 * 1024)
+#endif
+
+    /**
+     * @brief Sets the trace hook used by every vector without its own v->trace.
+     *
+     * @param hook Hook to call, NULL to disable tracing.
+     */
+    void vec_trace_set_global(vec_trace_func hook);
+
+    /**
+     * @brief Sets the smallest memmove, in bytes, reported as VEC_EVENT_MEMMOVE. Defaults to VEC_TRACE_MEMMOVE_THRESHOLD.
+     *
+     * @param bytes Threshold in bytes.
+     */
+    void vec_trace_set_memmove_threshold(size_t bytes);
+
+    /**
+     * @brief Opens a binary trace file and installs vec_trace_file_hook as the global hook.
+     *
+     * @param path File to create or truncate.
+     * @return int 0 on success, 1 on fail.
+     *
+     * @details Summarize the file with the bundled trace report tool (trace report.c).
+     */
+    int vec_trace_file_open(const char *path);
+
+    /**
+     * @brief Flushes and closes the trace file, uninstalls the global hook if it is vec_trace_file_hook.
+     */
+    void vec_trace_file_close(void);
+
+    /**
+     * @brief Built in hook appending one record per event to the file opened by vec_trace_file_open.
+     *
+     * @details Can also be set as v->trace on individual vectors. Does nothing while no file is open.
+     */
+    void vec_trace_file_hook(Vec *v, VecEvent event, size_t old_cap, size_t new_cap, size_t bytes, const char *tag);
+
+#ifdef VEC_ENABLE_STATS
+    /**
+     * @brief Returns the counters summed over every vector of the process, peaks are the largest of any vector.
+     *
+     * @return const VecStats* Process wide counters, not synchronized between threads.
+     */
+    const VecStats *vec_stats_global(void);
+
+    /**
+     * @brief Zeroes the process wide counters, the per vector counters are left alone.
+     */
+    void vec_stats_reset(void);
+
+    /**
+     * @brief Writes the process wide counters to out in a human readable form.
+     *
+     * @param out Stream to write to, such as stderr.
+     */
+    void vec_stats_dump(FILE *out);
+
+    /**
+     * @brief Writes the counters of a single vector to out in a human readable form.
+     *
+     * @param out Stream to write to, such as stderr.
+     * @param v Vector to report.
+     */
+    void vec_stats_dump_vec(FILE *out, Vec *v);
+#endif
+
 #ifdef __cplusplus
 } /* Extern "C" */
 #endif
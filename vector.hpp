@@ -0,0 +1,214 @@
+/**
+ * @file vector.hpp
+ * @brief Header only C++ wrapper owning a Vec, with move semantics and raw pointer iterators.
+ *
+ * @details Vector<T> holds nothing but the Vec pointer, so it costs what the C calls cost.
+ * Iterators are plain T *, which lets std::sort, std::lower_bound and range for loops inline fully,
+ * and push_back writes in place without a call while there is spare capacity.
+ * Copies are explicit through clone, moves hand over the Vec.
+ * adopt and release pass ownership to and from C code that works with Vec *.
+ * Link vector.c.
+ */
+
+#ifndef VECTOR_HPP_
+#define VECTOR_HPP_
+
+#include "vector.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename T>
+class Vector
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Vector<T>: Vec moves elements with memcpy, T must be trivially copyable.");
+
+public:
+    typedef T value_type;
+    typedef T &reference;
+    typedef const T &const_reference;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+    typedef size_t size_type;
+
+    Vector() : v_(make(VECTOR_DEFAULT_CAP)) {}
+
+    explicit Vector(size_t capacity) : v_(make(capacity)) {}
+
+    Vector(const Vector &) = delete;
+    Vector &operator=(const Vector &) = delete;
+
+    /* the moved from Vector may only be assigned to or destroyed */
+    Vector(Vector &&other) noexcept : v_(other.v_) { other.v_ = nullptr; }
+
+    Vector &operator=(Vector &&other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~Vector()
+    {
+        if (v_)
+            vec_free(v_);
+    }
+
+    /**
+     * @brief Takes ownership of a Vec created by the C API, its elem_size must be sizeof(T).
+     *
+     */
+    static Vector adopt(Vec *v)
+    {
+        VALIDATE_VECTOR(v);
+        VEC_ASSERT(v->elem_size == sizeof(T) && "Vector::adopt: elem_size does not match sizeof(T).");
+        return Vector(v, adopt_tag());
+    }
+
+    /**
+     * @brief Gives up ownership, the caller frees the returned Vec with vec_free. Leaves this Vector moved from.
+     *
+     */
+    Vec *release() noexcept
+    {
+        Vec *v = v_;
+        v_ = nullptr;
+        return v;
+    }
+
+    /**
+     * @brief Deep copy through vec_insert_n, keeps cmp but not the destructors.
+     *
+     */
+    Vector clone() const
+    {
+        Vector ret(size());
+        ret.v_->cmp = v_->cmp;
+        vec_insert_n(ret.v_, 0, v_->data, v_->len);
+        return ret;
+    }
+
+    Vec *get() noexcept { return v_; }
+    const Vec *get() const noexcept { return v_; }
+
+    T *data() noexcept { return reinterpret_cast<T *>(v_->data); }
+    const T *data() const noexcept { return reinterpret_cast<const T *>(v_->data); }
+    size_t size() const noexcept { return v_->len; }
+    size_t capacity() const noexcept { return v_->capacity; }
+    bool empty() const noexcept { return v_->len == 0; }
+
+    T &operator[](size_t i) noexcept { return data()[i]; }
+    const T &operator[](size_t i) const noexcept { return data()[i]; }
+    T &front() noexcept { return data()[0]; }
+    const T &front() const noexcept { return data()[0]; }
+    T &back() noexcept { return data()[v_->len - 1]; }
+    const T &back() const noexcept { return data()[v_->len - 1]; }
+
+    iterator begin() noexcept { return data(); }
+    iterator end() noexcept { return data() + v_->len; }
+    const_iterator begin() const noexcept { return data(); }
+    const_iterator end() const noexcept { return data() + v_->len; }
+    const_iterator cbegin() const noexcept { return data(); }
+    const_iterator cend() const noexcept { return data() + v_->len; }
+
+    void reserve(size_t n) { vec_reserve(v_, n); }
+
+    void push_back(const T &value)
+    {
+        if (v_->len < v_->capacity)
+        {
+            std::memcpy(v_->data + v_->len * sizeof(T), &value, sizeof(T));
+            v_->len++;
+            return;
+        }
+        /* value may live in the buffer that is about to grow */
+        T tmp = value;
+        vec_push_back(v_, &tmp);
+    }
+
+    template <typename... Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (v_->len < v_->capacity)
+            return *::new (vec_emplace_back(v_)) T(std::forward<Args>(args)...);
+        T tmp(std::forward<Args>(args)...);
+        return *::new (vec_emplace_back(v_)) T(tmp);
+    }
+
+    void pop_back() { vec_pop_back(v_); }
+
+    void clear() { vec_clear(v_); }
+
+    /* new elements are value initialized */
+    void resize(size_t n)
+    {
+        if (n < v_->len)
+        {
+            vec_remove_range(v_, n, v_->len - n);
+            return;
+        }
+        vec_reserve(v_, n);
+        for (T *p = end(); p != data() + n; ++p)
+            ::new (p) T();
+        v_->len = n;
+    }
+
+    iterator insert(const_iterator pos, const T &value)
+    {
+        size_t idx = static_cast<size_t>(pos - data());
+        T tmp = value;
+        vec_insert(v_, idx, &tmp);
+        return data() + idx;
+    }
+
+    iterator insert(const_iterator pos, const T *first, const T *last)
+    {
+        size_t idx = static_cast<size_t>(pos - data());
+        vec_insert_n(v_, idx, first, static_cast<size_t>(last - first));
+        return data() + idx;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        size_t idx = static_cast<size_t>(pos - data());
+        vec_remove(v_, idx);
+        return data() + idx;
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_t idx = static_cast<size_t>(first - data());
+        vec_remove_range(v_, idx, static_cast<size_t>(last - first));
+        return data() + idx;
+    }
+
+    void swap(Vector &other) noexcept { std::swap(v_, other.v_); }
+
+private:
+    struct adopt_tag
+    {
+    };
+
+    Vector(Vec *v, adopt_tag) noexcept : v_(v) {}
+
+    /* over aligned types get storage aligned for them */
+    static Vec *make(size_t capacity)
+    {
+        size_t align = alignof(T) > alignof(std::max_align_t) ? alignof(T) : 0;
+        return vec_new_aligned(capacity, sizeof(T), align, NULL, NULL, NULL);
+    }
+
+    Vec *v_;
+};
+
+template <typename T>
+void swap(Vector<T> &a, Vector<T> &b) noexcept
+{
+    a.swap(b);
+}
+
+#endif /* VECTOR_HPP_ */